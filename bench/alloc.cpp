@@ -0,0 +1,79 @@
+//
+//  alloc.cpp
+//  tiny
+//
+//  Created by Иван Дмитриевский on 18/10/26.
+//  Copyright (c) 2026 Ivan Dmitrievsky. All rights reserved.
+//
+//  Heap allocations made by the parser engines once warmed up: the same
+//  input is parsed again into the same trace buffer under a counting
+//  operator new, which must stay at zero.
+//
+
+#include "bench.h"
+
+#include "format.h"
+#include "lexer.h"
+#include "parser.h"
+
+#include <cstdlib>
+#include <new>
+
+namespace {
+size_t allocations = 0;
+}
+
+__attribute__((noinline)) void *operator new(size_t size) {
+  ++allocations;
+  if (void *p = malloc(size ? size : 1)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void operator delete(void *p) noexcept {
+  free(p);
+}
+
+int main(int argc, const char *argv[]) {
+  std::unique_ptr<tiny::grammar> gramm = bench::grammar(argc, argv);
+  const tiny::grammar &g = *gramm;
+
+  std::string text;
+  std::unique_ptr<tiny::source> src;
+  if (argc > 2) {
+    src.reset(new tiny::source(argv[2]));
+  } else {
+    text = bench::program(100000);
+    src.reset(new tiny::source(text.data(), text.size()));
+  }
+
+  tiny::lex l(g);
+  tiny::tokbuf tokens;
+  l.run(*src, tokens);
+
+  int failed = 0;
+  const tiny::parser::engine engines[] = {tiny::parser::engine::table,
+                                          tiny::parser::engine::climb,
+                                          tiny::parser::engine::descent};
+  const char *names[] = {"table", "climb", "descent"};
+  for (int e = 0; e < 3; ++e) {
+    tiny::parser p(g, engines[e]);
+    tiny::parser::trace rules;
+    p.run(tokens, *src, rules);
+
+    size_t before = allocations;
+    p.run(tokens, *src, rules);
+    size_t buffered = allocations - before;
+
+    before = allocations;
+    l.open(*src);
+    p.run(l, rules);
+    size_t streamed = allocations - before;
+
+    fmt::printf("%-8s %d tokens: %d allocations buffered, %d streamed\n",
+                names[e], tokens.size(), buffered, streamed);
+    failed |= buffered != 0 || streamed != 0;
+  }
+  return failed ? EXIT_FAILURE : 0;
+}
@@ -0,0 +1,57 @@
+//
+//  ast.cpp
+//  tiny
+//
+//  Created by Иван Дмитриевский on 18/10/26.
+//  Copyright (c) 2026 Ivan Dmitrievsky. All rights reserved.
+//
+//  Cost of turning a parse into a tree and of throwing it away again.
+//
+
+#include "bench.h"
+
+#include "ast.h"
+#include "format.h"
+#include "lexer.h"
+#include "parser.h"
+
+#include <memory>
+
+int main(int argc, const char *argv[]) {
+  std::unique_ptr<tiny::grammar> gramm = bench::grammar(argc, argv);
+  const tiny::grammar &g = *gramm;
+
+  std::string text;
+  std::unique_ptr<tiny::source> src;
+  if (argc > 2) {
+    src.reset(new tiny::source(argv[2]));
+  } else {
+    text = bench::program(1000000);
+    src.reset(new tiny::source(text.data(), text.size()));
+  }
+
+  tiny::lex l(g);
+  tiny::tokbuf tokens;
+  l.run(*src, tokens);
+  tiny::parser p(g, tiny::parser::engine::descent);
+  tiny::parser::trace rules;
+  if (!p.run(tokens, *src, rules)) {
+    return EXIT_FAILURE;
+  }
+
+  tiny::ast tree;
+  bench::timer built;
+  tree.build(g, rules, tokens, *src);
+  double buildSecs = built.seconds();
+  size_t nodes = tree.size(), bytes = tree.bytes();
+
+  bench::timer freed;
+  tree.clear();
+  double freeSecs = freed.seconds();
+
+  fmt::printf("%d tokens, %d rules, %d nodes, %.1f MB of nodes\n",
+              tokens.size(), rules.size(), nodes, bytes / 1e6);
+  fmt::printf("build: %8.1f M nodes/s\n", nodes / buildSecs / 1e6);
+  fmt::printf("free:  %8.3f ms\n", freeSecs * 1e3);
+  return 0;
+}
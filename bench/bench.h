@@ -0,0 +1,102 @@
+//
+//  bench.h
+//  tiny
+//
+//  Created by Иван Дмитриевский on 18/10/26.
+//  Copyright (c) 2026 Ivan Dmitrievsky. All rights reserved.
+//
+
+#ifndef __tiny__bench__
+#define __tiny__bench__
+
+#include "grammar.h"
+
+#include <chrono>
+#include <memory>
+#include <random>
+#include <string>
+
+namespace bench {
+class timer {
+public:
+  timer() : _start(std::chrono::steady_clock::now()) {}
+
+  double seconds() const {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                         _start)
+        .count();
+  }
+
+private:
+  std::chrono::steady_clock::time_point _start;
+};
+
+// A syntactically valid TINY program with roughly `stmts` statements, long
+// identifiers and deep indentation, like the generated code we lex in bulk.
+inline std::string program(size_t stmts, unsigned seed = 42) {
+  std::mt19937 rng(seed);
+  auto var = [&rng]() {
+    return "variable_with_a_rather_long_name_" + std::to_string(rng() % 64);
+  };
+  auto num = [&rng]() { return std::to_string(rng() % 1000000); };
+  auto exp = [&]() {
+    std::string e = var();
+    static const char *ops[] = {" + ", " - ", " * ", " / "};
+    for (unsigned n = rng() % 4; n > 0; --n) {
+      e += ops[rng() % 4];
+      e += rng() % 2 ? var() : "(" + var() + " - " + num() + ")";
+    }
+    return e;
+  };
+
+  std::string src;
+  for (int i = 0; i < 64; ++i) {
+    src += "let variable_with_a_rather_long_name_" + std::to_string(i) +
+           " = " + num() + "\n";
+  }
+  src += "begin\n";
+  std::string indent = "    ";
+  size_t depth = 0;
+  bool opened = false;
+  for (size_t i = 0; i < stmts || opened; ++i) {
+    unsigned kind = rng() % 8;
+    if (kind == 0 && depth < 8 && i + 1 < stmts) {
+      src += indent + (rng() % 2 ? "while " : "if ") + exp() + " < " + num() +
+             "\n";
+      indent += "    ";
+      ++depth;
+      opened = true;
+      continue;
+    }
+    if (kind == 1 && depth > 0 && !opened) {
+      indent.resize(indent.size() - 4);
+      src += indent + "end\n";
+      --depth;
+    } else if (kind == 2) {
+      src += indent + "print " + exp() + ", " + exp() + "\n";
+    } else {
+      src += indent + var() + " = " + exp() + "\n";
+    }
+    opened = false;
+  }
+  for (; depth > 0; --depth) {
+    indent.resize(indent.size() - 4);
+    src += indent + "end\n";
+  }
+  src += "end\n";
+  return src;
+}
+
+// The compiled-in grammar, or the one given as the first argument.
+inline std::unique_ptr<tiny::grammar> grammar(int argc, const char *argv[]) {
+  return std::unique_ptr<tiny::grammar>(
+      argc > 1 ? new tiny::grammar(argv[1]) : new tiny::grammar());
+}
+
+// Keeps the optimizer from discarding a computed value.
+template <class T> void keep(const T &v) {
+  asm volatile("" : : "g"(&v) : "memory");
+}
+}
+
+#endif /* defined(__tiny__bench__) */
@@ -0,0 +1,92 @@
+//
+//  interp.cpp
+//  tiny
+//
+//  Created by Иван Дмитриевский on 18/10/26.
+//  Copyright (c) 2026 Ivan Dmitrievsky. All rights reserved.
+//
+//  Running time of the tree-walking interpreter and of the bytecode machine
+//  on the programs in bench/programs, or on the ones given after the
+//  grammar, and how many instructions a second the machine gets through.
+//  Program output goes to /dev/null.
+//
+
+#include "bench.h"
+
+#include "ast.h"
+#include "bytecode.h"
+#include "fdwriter.h"
+#include "format.h"
+#include "interp.h"
+#include "lexer.h"
+#include "parser.h"
+#include "scope.h"
+#include "vm.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+int main(int argc, const char *argv[]) {
+  std::unique_ptr<tiny::grammar> gramm = bench::grammar(argc, argv);
+  const tiny::grammar &g = *gramm;
+
+  std::vector<std::string> paths(argv + std::min(argc, 2), argv + argc);
+  if (paths.empty()) {
+    for (const char *name : {"loops", "gcd", "primes"}) {
+      paths.push_back(std::string("bench/programs/") + name + ".tiny");
+    }
+  }
+
+  int null = open("/dev/null", O_WRONLY);
+  if (null < 0) {
+    fmt::printf("Cannot open /dev/null\n");
+    return EXIT_FAILURE;
+  }
+
+  tiny::lex l(g);
+  tiny::parser p(g, tiny::parser::engine::descent);
+  for (const std::string &path : paths) {
+    tiny::source src(path);
+    tiny::tokbuf tokens;
+    l.run(src, tokens);
+    tiny::parser::trace rules;
+    if (!p.run(tokens, src, rules)) {
+      return EXIT_FAILURE;
+    }
+    tiny::ast tree;
+    tree.build(g, rules, tokens, src);
+
+    bench::timer resolved;
+    tiny::scope vars(tree);
+    double resolveSecs = resolved.seconds();
+    bench::timer compiled;
+    tiny::bytecode code(tree, vars);
+    double compileSecs = compiled.seconds();
+
+    tiny::fdwriter out(null);
+    tiny::interp walker(tree);
+    bench::timer walked;
+    walker.run(out);
+    double walkSecs = walked.seconds();
+
+    tiny::vm machine(code);
+    uint64_t executed = machine.count(out);
+    bench::timer ran;
+    machine.run(out);
+    double runSecs = ran.seconds();
+
+    fmt::printf("%s: %d slots, %d instructions, resolve %.3f ms, compile "
+                "%.3f ms\n",
+                path, vars.size(), code.code().size(), resolveSecs * 1e3,
+                compileSecs * 1e3);
+    fmt::printf("  tree: %7.3f s\n", walkSecs);
+    fmt::printf("  vm:   %7.3f s, %.0f M executed, %8.1f M instructions/s\n",
+                runSecs, executed / 1e6, executed / runSecs / 1e6);
+  }
+  close(null);
+  return 0;
+}
@@ -0,0 +1,68 @@
+//
+//  lex.cpp
+//  tiny
+//
+//  Created by Иван Дмитриевский on 18/10/26.
+//  Copyright (c) 2026 Ivan Dmitrievsky. All rights reserved.
+//
+//  Lexer throughput for every character scanning path this CPU supports,
+//  checking that each one produces the same tokens as the scalar path.
+//
+
+#include "bench.h"
+
+#include "format.h"
+#include "lexer.h"
+#include "scan.h"
+
+#include <memory>
+
+int main(int argc, const char *argv[]) {
+  std::unique_ptr<tiny::grammar> gramm = bench::grammar(argc, argv);
+  const tiny::grammar &g = *gramm;
+
+  std::string text;
+  std::unique_ptr<tiny::source> src;
+  if (argc > 2) {
+    src.reset(new tiny::source(argv[2]));
+  } else {
+    text = bench::program(1000000);
+    src.reset(new tiny::source(text.data(), text.size()));
+  }
+
+  tiny::lex l(g);
+  tiny::tokbuf expected;
+  double mb = src->size() / 1e6;
+  fmt::printf("%.1f MB of input\n", mb);
+
+  for (auto isa : {tiny::scan::isa::scalar, tiny::scan::isa::sse2,
+                   tiny::scan::isa::avx2}) {
+    if (!tiny::scan::select(isa)) {
+      continue;
+    }
+
+    tiny::tokbuf tokens;
+    bench::timer t;
+    l.run(*src, tokens);
+    double secs = t.seconds();
+
+    if (isa == tiny::scan::isa::scalar) {
+      l.run(*src, expected);
+    }
+    bool same = tokens.size() == expected.size();
+    for (size_t i = 0; same && i < tokens.size(); ++i) {
+      auto a = tokens[i], b = expected[i];
+      same = a._off == b._off && a._len == b._len && a._sym == b._sym &&
+             a._num == b._num;
+    }
+
+    fmt::printf("%-6s %10d tokens %8.1f MB/s %5.1f bytes/token%s\n",
+                tiny::scan::name(isa), tokens.size(), mb / secs,
+                double(tokens.bytes()) / tokens.size(),
+                same ? "" : "  MISMATCH");
+    if (!same) {
+      return EXIT_FAILURE;
+    }
+  }
+  return 0;
+}
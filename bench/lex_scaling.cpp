@@ -0,0 +1,78 @@
+//
+//  lex_scaling.cpp
+//  tiny
+//
+//  Created by Иван Дмитриевский on 18/10/26.
+//  Copyright (c) 2026 Ivan Dmitrievsky. All rights reserved.
+//
+//  Chunked parallel lexing from one thread up to every core, checked
+//  against the sequential lexer token by token.
+//
+
+#include "bench.h"
+
+#include "format.h"
+#include "lexer.h"
+
+#include <memory>
+
+static bool same(const tiny::tokbuf &a, const tiny::tokbuf &b) {
+  if (a.size() != b.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < a.size(); ++i) {
+    auto x = a[i], y = b[i];
+    if (x._off != y._off || x._len != y._len || x._sym != y._sym ||
+        x._num != y._num) {
+      return false;
+    }
+  }
+  return true;
+}
+
+int main(int argc, const char *argv[]) {
+  std::unique_ptr<tiny::grammar> gramm = bench::grammar(argc, argv);
+  const tiny::grammar &g = *gramm;
+
+  std::string text;
+  std::unique_ptr<tiny::source> src;
+  if (argc > 2) {
+    src.reset(new tiny::source(argv[2]));
+  } else {
+    text = bench::program(1000000);
+    src.reset(new tiny::source(text.data(), text.size()));
+  }
+
+  tiny::lex l(g);
+  tiny::tokbuf expected;
+  double mb = src->size() / 1e6;
+
+  bench::timer sequential;
+  l.run(*src, expected);
+  double base = sequential.seconds();
+  fmt::printf("%.1f MB, %d tokens\n", mb, expected.size());
+  fmt::printf("sequential %8.1f MB/s\n", mb / base);
+
+  size_t cores = std::max(1u, std::thread::hardware_concurrency());
+  std::vector<size_t> counts;
+  for (size_t n = 1; n < cores; n *= 2) {
+    counts.push_back(n);
+  }
+  counts.push_back(cores);
+
+  for (auto n : counts) {
+    tiny::pool workers(n);
+    tiny::tokbuf tokens;
+    bench::timer t;
+    l.run(*src, tokens, workers);
+    double secs = t.seconds();
+
+    bool ok = same(tokens, expected);
+    fmt::printf("%3d threads %8.1f MB/s %6.2fx%s\n", n, mb / secs,
+                base / secs, ok ? "" : "  MISMATCH");
+    if (!ok) {
+      return EXIT_FAILURE;
+    }
+  }
+  return 0;
+}
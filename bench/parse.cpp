@@ -0,0 +1,87 @@
+//
+//  parse.cpp
+//  tiny
+//
+//  Created by Иван Дмитриевский on 18/10/26.
+//  Copyright (c) 2026 Ivan Dmitrievsky. All rights reserved.
+//
+//  Parser throughput when fed straight from the lexer stream and when
+//  walking a prefilled token buffer, for every engine. All must produce the
+//  same rule trace; the climbing engine is also timed without expression
+//  rules in its trace.
+//
+
+#include "bench.h"
+
+#include "format.h"
+#include "lexer.h"
+#include "parser.h"
+
+#include <memory>
+
+int main(int argc, const char *argv[]) {
+  std::unique_ptr<tiny::grammar> gramm = bench::grammar(argc, argv);
+  const tiny::grammar &g = *gramm;
+
+  std::string text;
+  std::unique_ptr<tiny::source> src;
+  if (argc > 2) {
+    src.reset(new tiny::source(argv[2]));
+  } else {
+    text = bench::program(200000);
+    src.reset(new tiny::source(text.data(), text.size()));
+  }
+
+  tiny::lex l(g);
+  tiny::parser p(g);
+  double mb = src->size() / 1e6;
+
+  bench::timer streamed;
+  l.open(*src);
+  tiny::parser::trace fromStream;
+  p.run(l, fromStream);
+  double streamSecs = streamed.seconds();
+
+  tiny::tokbuf tokens;
+  bench::timer lexed;
+  l.run(*src, tokens);
+  double lexSecs = lexed.seconds();
+  bench::timer parsed;
+  tiny::parser::trace fromBuffer;
+  p.run(tokens, *src, fromBuffer);
+  double parseSecs = parsed.seconds();
+
+  tiny::parser c(g, tiny::parser::engine::climb);
+  tiny::parser::trace fromClimb;
+  bench::timer climbed;
+  c.run(tokens, *src, fromClimb);
+  double climbSecs = climbed.seconds();
+
+  tiny::parser::trace statements;
+  c.exprTrace(false);
+  bench::timer checked;
+  c.run(tokens, *src, statements);
+  double checkSecs = checked.seconds();
+
+  tiny::parser d(g, tiny::parser::engine::descent);
+  bench::timer descended;
+  tiny::parser::trace fromDescent;
+  d.run(tokens, *src, fromDescent);
+  double descentSecs = descended.seconds();
+
+  fmt::printf("%.1f MB, %d tokens, %d rules\n", mb, tokens.size(),
+              fromStream.size());
+  fmt::printf("stream: lex+parse %8.1f MB/s\n", mb / streamSecs);
+  fmt::printf("buffer: lex %8.1f MB/s, parse %8.1f MB/s\n", mb / lexSecs,
+              mb / parseSecs);
+  fmt::printf("climb: parse %8.1f MB/s, without expressions %8.1f MB/s\n",
+              mb / climbSecs, mb / checkSecs);
+  fmt::printf("descent: parse %8.1f MB/s\n", mb / descentSecs);
+
+  if (fromStream != fromBuffer || fromBuffer != fromDescent ||
+      fromBuffer != fromClimb) {
+    fmt::printf("rule traces differ\n");
+    return EXIT_FAILURE;
+  }
+  return 0;
+}
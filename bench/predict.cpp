@@ -0,0 +1,83 @@
+//
+//  predict.cpp
+//  tiny
+//
+//  Created by Иван Дмитриевский on 18/10/26.
+//  Copyright (c) 2026 Ivan Dmitrievsky. All rights reserved.
+//
+//  Predict table lookups per second: the dense id matrix used by grammar
+//  against the string-keyed std::map it replaced. Also how many rules the
+//  table loop applies per step with expansions folded in.
+//
+
+#include "bench.h"
+
+#include "expansions.h"
+#include "format.h"
+#include "grammar.h"
+
+#include <map>
+#include <random>
+
+int main(int argc, const char *argv[]) {
+  std::unique_ptr<tiny::grammar> gramm = bench::grammar(argc, argv);
+  const tiny::grammar &g = *gramm;
+
+  std::map<std::pair<std::string, std::string>, size_t> old;
+  std::vector<std::pair<tiny::symtab::id, tiny::symtab::id>> ids;
+  std::vector<std::pair<std::string, std::string>> names;
+  for (size_t l = 0; l < g.nonterms().size(); ++l) {
+    for (size_t t = 0; t < g.terms().size(); ++t) {
+      bool found = false;
+      size_t rule = g.predict(l, t, found);
+      if (found) {
+        old.insert({{g.nonterms().name(l), g.terms().name(t)}, rule});
+        ids.push_back({l, t});
+        names.push_back({g.nonterms().name(l), g.terms().name(t)});
+      }
+    }
+  }
+
+  const size_t n = 1 << 16, rounds = 64;
+  std::vector<size_t> order(n);
+  std::mt19937 rng(42);
+  for (auto &i : order) {
+    i = rng() % ids.size();
+  }
+
+  auto oldPredict = [&old](std::string l, std::string t, bool &found) {
+    auto num = old.find({l, t});
+    found = (num != old.end());
+    return num->second;
+  };
+
+  size_t sum = 0;
+  bench::timer before;
+  for (size_t r = 0; r < rounds; ++r) {
+    for (auto i : order) {
+      bool found;
+      sum += oldPredict(names[i].first, names[i].second, found);
+    }
+  }
+  double oldSecs = before.seconds();
+  bench::keep(sum);
+
+  sum = 0;
+  bench::timer after;
+  for (size_t r = 0; r < rounds; ++r) {
+    for (auto i : order) {
+      bool found;
+      sum += g.predict(ids[i].first, ids[i].second, found);
+    }
+  }
+  double newSecs = after.seconds();
+  bench::keep(sum);
+
+  double total = double(n) * rounds;
+  fmt::printf("%d predict entries, %.0f lookups\n", ids.size(), total);
+  fmt::printf("std::map<string, string>: %12.0f lookups/s\n", total / oldSecs);
+  fmt::printf("dense id matrix:          %12.0f lookups/s\n", total / newSecs);
+  fmt::printf("speedup:                  %12.1fx\n", oldSecs / newSecs);
+  fmt::printf("rules per expansion:      %12.2f\n", tiny::expansions(g).fold());
+  return 0;
+}
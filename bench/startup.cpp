@@ -0,0 +1,55 @@
+//
+//  startup.cpp
+//  tiny
+//
+//  Created by Иван Дмитриевский on 18/10/26.
+//  Copyright (c) 2026 Ivan Dmitrievsky. All rights reserved.
+//
+//  Time to get a usable grammar: parsing and analysing the JSON rules,
+//  mapping a precompiled image, or pointing at the tables compiled into the
+//  binary.
+//
+
+#include "bench.h"
+
+#include "format.h"
+#include "grammar.h"
+
+#include <cstdio>
+
+int main(int argc, const char *argv[]) {
+  const char *grammarPath = argc > 1 ? argv[1] : "grammar.json";
+  const char *imagePath = "bench_startup.img";
+  const int rounds = 1000;
+
+  tiny::grammar(grammarPath).save(imagePath);
+
+  size_t sum = 0;
+  bench::timer json;
+  for (int i = 0; i < rounds; ++i) {
+    tiny::grammar g(grammarPath);
+    sum += g.rules();
+  }
+  double jsonSecs = json.seconds();
+
+  bench::timer builtin;
+  for (int i = 0; i < rounds; ++i) {
+    tiny::grammar g;
+    sum += g.rules();
+  }
+  double builtinSecs = builtin.seconds();
+
+  bench::timer image;
+  for (int i = 0; i < rounds; ++i) {
+    tiny::grammar g(imagePath);
+    sum += g.rules();
+  }
+  double imageSecs = image.seconds();
+  bench::keep(sum);
+  remove(imagePath);
+
+  fmt::printf("json:  %8.1f us per load\n", jsonSecs / rounds * 1e6);
+  fmt::printf("image: %8.1f us per load\n", imageSecs / rounds * 1e6);
+  fmt::printf("built-in: %5.1f us per load\n", builtinSecs / rounds * 1e6);
+  return 0;
+}
@@ -0,0 +1,84 @@
+//
+//  trace.cpp
+//  tiny
+//
+//  Created by Иван Дмитриевский on 18/10/26.
+//  Copyright (c) 2026 Ivan Dmitrievsky. All rights reserved.
+//
+//  Size of a rule trace as text, as raw bytes and packed, and how fast the
+//  packed form is written and replayed.
+//
+
+#include "bench.h"
+
+#include "format.h"
+#include "lexer.h"
+#include "parser.h"
+#include "tracefile.h"
+
+#include <cstdlib>
+
+#include <unistd.h>
+
+int main(int argc, const char *argv[]) {
+  std::unique_ptr<tiny::grammar> gramm = bench::grammar(argc, argv);
+  const tiny::grammar &g = *gramm;
+
+  std::string text;
+  std::unique_ptr<tiny::source> src;
+  if (argc > 2) {
+    src.reset(new tiny::source(argv[2]));
+  } else {
+    text = bench::program(1000000);
+    src.reset(new tiny::source(text.data(), text.size()));
+  }
+
+  tiny::lex l(g);
+  tiny::tokbuf tokens;
+  l.run(*src, tokens);
+  tiny::parser p(g, tiny::parser::engine::descent);
+  tiny::parser::trace rules;
+  if (!p.run(tokens, *src, rules)) {
+    return EXIT_FAILURE;
+  }
+
+  fmt::MemoryWriter vis;
+  p.vis(rules, vis);
+
+  char path[] = "/tmp/tinytraceXXXXXX";
+  int fd = mkstemp(path);
+  if (fd < 0) {
+    fmt::printf("Cannot create %s\n", path);
+    return EXIT_FAILURE;
+  }
+  double writeSecs;
+  {
+    tiny::tracewriter w(fd, g);
+    bench::timer t;
+    w.put(rules, true);
+    w.flush();
+    writeSecs = t.seconds();
+  }
+  close(fd);
+  tiny::source in(path);
+  unlink(path);
+
+  tiny::tracereader r(in, g);
+  tiny::parser::trace replayed;
+  bool parsed;
+  bench::timer t;
+  r.next(replayed, parsed);
+  double replaySecs = t.seconds();
+
+  if (replayed != rules) {
+    fmt::printf("Replayed trace differs\n");
+    return EXIT_FAILURE;
+  }
+
+  fmt::printf("%d rules: text %.1f MB, bytes %.1f MB, packed %.1f MB\n",
+              rules.size(), vis.size() / 1e6, rules.size() / 1e6,
+              in.size() / 1e6);
+  fmt::printf("write:  %8.1f M rules/s\n", rules.size() / writeSecs / 1e6);
+  fmt::printf("replay: %8.1f M rules/s\n", rules.size() / replaySecs / 1e6);
+  return 0;
+}
@@ -0,0 +1,64 @@
+//
+//  vis.cpp
+//  tiny
+//
+//  Created by Иван Дмитриевский on 18/10/26.
+//  Copyright (c) 2026 Ivan Dmitrievsky. All rights reserved.
+//
+//  Output throughput of every trace format, written to /dev/null.
+//
+
+#include "bench.h"
+
+#include "format.h"
+#include "lexer.h"
+#include "parser.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+int main(int argc, const char *argv[]) {
+  std::unique_ptr<tiny::grammar> gramm = bench::grammar(argc, argv);
+  const tiny::grammar &g = *gramm;
+
+  std::string text;
+  std::unique_ptr<tiny::source> src;
+  if (argc > 2) {
+    src.reset(new tiny::source(argv[2]));
+  } else {
+    text = bench::program(200000);
+    src.reset(new tiny::source(text.data(), text.size()));
+  }
+
+  tiny::lex l(g);
+  tiny::tokbuf tokens;
+  l.run(*src, tokens);
+  tiny::parser p(g);
+  tiny::parser::trace rules;
+  if (!p.run(tokens, *src, rules)) {
+    return EXIT_FAILURE;
+  }
+
+  int devnull = open("/dev/null", O_WRONLY);
+  static const struct {
+    const char *_name;
+    tiny::parser::format _format;
+  } formats[] = {{"text", tiny::parser::format::text},
+                 {"jsonl", tiny::parser::format::jsonl},
+                 {"dot", tiny::parser::format::dot}};
+
+  fmt::printf("%d rules\n", rules.size());
+  for (auto &f : formats) {
+    fmt::MemoryWriter sized;
+    p.vis(rules, sized, f._format);
+
+    bench::timer t;
+    p.vis(rules, devnull, f._format);
+    double secs = t.seconds();
+    fmt::printf("%-6s %8.1f MB  %8.1f MB/s  %8.1f M rules/s\n", f._name,
+                sized.size() / 1e6, sized.size() / secs / 1e6,
+                rules.size() / secs / 1e6);
+  }
+  close(devnull);
+  return 0;
+}
@@ -0,0 +1,118 @@
+//
+//  analysis.cpp
+//  tiny
+//
+//  Created by Иван Дмитриевский on 18/10/26.
+//  Copyright (c) 2026 Ivan Dmitrievsky. All rights reserved.
+//
+
+#include "analysis.h"
+
+#include "format.h"
+
+namespace tiny {
+const size_t analysis::end;
+
+analysis::analysis(const grammar &gramm)
+    : _gramm(gramm), _nullable(gramm.nonterms().size(), false),
+      _first(gramm.nonterms().size()), _follow(gramm.nonterms().size()),
+      _predicts(gramm.nonterms().size() * gramm.terms().size(), 0) {
+  size_t rules = gramm.rules();
+  std::vector<bool> defined(gramm.nonterms().size(), false);
+  for (size_t r = 0; r < rules; ++r) {
+    defined[gramm.lhs(r)._id] = true;
+  }
+  for (size_t nt = 0; nt < defined.size(); ++nt) {
+    if (!defined[nt]) {
+      _undefined.push_back(nt);
+    }
+  }
+  if (rules == 0) {
+    return;
+  }
+
+  for (bool changed = true; changed;) {
+    changed = false;
+    for (size_t r = 0; r < rules; ++r) {
+      symtab::id lhs = gramm.lhs(r)._id;
+      termset f;
+      bool n = first(gramm.rhs(r), 0, f);
+      if ((f & ~_first[lhs]).any()) {
+        _first[lhs] |= f;
+        changed = true;
+      }
+      if (n && !_nullable[lhs]) {
+        _nullable[lhs] = true;
+        changed = true;
+      }
+    }
+  }
+
+  _follow[gramm.lhs(0)._id].set(end);
+  for (bool changed = true; changed;) {
+    changed = false;
+    for (size_t r = 0; r < rules; ++r) {
+      grammar::span body = gramm.rhs(r);
+      for (size_t i = 0; i < body.size(); ++i) {
+        if (body[i]._term) {
+          continue;
+        }
+        termset f;
+        if (first(body, i + 1, f)) {
+          f |= _follow[gramm.lhs(r)._id];
+        }
+        termset &fol = _follow[body[i]._id];
+        if ((f & ~fol).any()) {
+          fol |= f;
+          changed = true;
+        }
+      }
+    }
+  }
+
+  size_t terms = gramm.terms().size();
+  for (size_t r = 0; r < rules; ++r) {
+    symtab::id lhs = gramm.lhs(r)._id;
+    termset f;
+    if (first(gramm.rhs(r), 0, f)) {
+      f |= _follow[lhs];
+    }
+    for (size_t t = 0; t < terms; ++t) {
+      if (!f[t]) {
+        continue;
+      }
+      uint8_t &cell = _predicts[lhs * terms + t];
+      if (cell == 0) {
+        cell = r + 1;
+      } else {
+        _conflicts.push_back({lhs, symtab::id(t), size_t(cell - 1), r});
+      }
+    }
+  }
+}
+
+bool analysis::first(grammar::span body, size_t from, termset &out) const {
+  for (size_t i = from; i < body.size(); ++i) {
+    if (body[i]._term) {
+      out.set(body[i]._id);
+      return false;
+    }
+    out |= _first[body[i]._id];
+    if (!_nullable[body[i]._id]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void analysis::report() const {
+  for (auto nt : _undefined) {
+    fmt::printf("Nonterminal <%s> has no rules\n", _gramm.nonterms().name(nt));
+  }
+  for (auto &c : _conflicts) {
+    fmt::printf("LL(1) conflict in <%s> on %s between rules %d and %d\n",
+                _gramm.nonterms().name(c._nonterm),
+                _gramm.terms().name(c._term), c._kept + 1, c._lost + 1);
+  }
+}
+}
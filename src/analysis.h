@@ -0,0 +1,61 @@
+//
+//  analysis.h
+//  tiny
+//
+//  Created by Иван Дмитриевский on 18/10/26.
+//  Copyright (c) 2026 Ivan Dmitrievsky. All rights reserved.
+//
+
+#ifndef __tiny__analysis__
+#define __tiny__analysis__
+
+#include "grammar.h"
+
+#include <bitset>
+#include <cstdint>
+#include <vector>
+
+namespace tiny {
+// Nullable, FIRST and FOLLOW sets of the grammar rules and the LL(1)
+// predict table built from them. The first rule's head is the start
+// symbol. Cells hold rule + 1, 0 is an error; a cell claimed by two rules
+// is a conflict, the earlier rule keeps it.
+class analysis {
+public:
+  typedef std::bitset<256> termset;
+  static const size_t end = 255;
+
+  struct conflict {
+    symtab::id _nonterm;
+    symtab::id _term;
+    size_t _kept;
+    size_t _lost;
+  };
+
+  explicit analysis(const grammar &gramm);
+
+  bool nullable(symtab::id nt) const { return _nullable[nt]; }
+  const termset &first(symtab::id nt) const { return _first[nt]; }
+  const termset &follow(symtab::id nt) const { return _follow[nt]; }
+
+  const std::vector<uint8_t> &predicts() const { return _predicts; }
+  const std::vector<conflict> &conflicts() const { return _conflicts; }
+  const std::vector<symtab::id> &undefined() const { return _undefined; }
+
+  bool ll1() const { return _conflicts.empty() && _undefined.empty(); }
+  void report() const;
+
+private:
+  const grammar &_gramm;
+  std::vector<bool> _nullable;
+  std::vector<termset> _first;
+  std::vector<termset> _follow;
+  std::vector<uint8_t> _predicts;
+  std::vector<conflict> _conflicts;
+  std::vector<symtab::id> _undefined;
+
+  bool first(grammar::span body, size_t from, termset &out) const;
+};
+}
+
+#endif /* defined(__tiny__analysis__) */
@@ -0,0 +1,330 @@
+//
+//  ast.cpp
+//  tiny
+//
+//  Created by Иван Дмитриевский on 18/10/26.
+//  Copyright (c) 2026 Ivan Dmitrievsky. All rights reserved.
+//
+
+#include "ast.h"
+
+#include "format.h"
+
+namespace tiny {
+const ast::ref ast::nil;
+
+// Walks the trace in the order the parser produced it, taking a token for
+// every terminal of an applied rule. Tail and optional rules are read in
+// loops, so long lists do not recurse.
+class ast::builder {
+public:
+  builder(ast &tree, const grammar &gramm, const parser::trace &rules,
+          const tokbuf &tokens, const source &src)
+      : _t(tree), _g(gramm), _rules(rules), _tok(tokens, src),
+        _if(gramm.mnt("if")._id), _while(gramm.mnt("while")._id),
+        _print(gramm.mnt("print")._id), _ident(gramm.mt("ident")._id),
+        _num(gramm.mt("num")._id), _ops(gramm.terms().size(), kind::add) {
+    static const struct {
+      const char *_name;
+      kind _kind;
+    } ops[] = {{"|", kind::lor}, {"&", kind::land}, {"<", kind::lt},
+               {"<=", kind::le}, {">", kind::gt},   {">=", kind::ge},
+               {"=", kind::eq},  {"/=", kind::ne},  {"+", kind::add},
+               {"-", kind::sub}, {"*", kind::mul},  {"/", kind::div}};
+    for (auto &op : ops) {
+      symtab::id t = gramm.terms().find(op._name);
+      if (t != symtab::none) {
+        _ops[t] = op._kind;
+      }
+    }
+  }
+
+  void program() {
+    ref root = _t.make(kind::program);
+    next();
+    ref decls = nil, last = nil;
+    while (more()) {
+      next();
+      take();
+      next();
+      link(decls, last, var());
+      while (more()) {
+        take();
+        link(decls, last, var());
+      }
+    }
+    next();
+    take();
+    ref body = block();
+    take();
+    _t._nodes[root]._a = decls;
+    _t._nodes[root]._b = body;
+  }
+
+private:
+  ast &_t;
+  const grammar &_g;
+  const parser::trace &_rules;
+  size_t _r = 0;
+  tokbuf::cursor _tok;
+  symtab::id _if;
+  symtab::id _while;
+  symtab::id _print;
+  symtab::id _ident;
+  symtab::id _num;
+  std::vector<kind> _ops;
+
+  size_t next() { return _rules[_r++]; }
+  bool more() { return !_g.rhs(next()).empty(); }
+
+  token take() {
+    token t = _tok.peek();
+    _tok.advance();
+    return t;
+  }
+
+  void link(ref &head, ref &last, ref r) {
+    if (head == nil) {
+      head = r;
+    } else {
+      _t._nodes[last]._next = r;
+    }
+    last = r;
+  }
+
+  ref ident(const token &t) { return _t.make(kind::ident, t._off, t._len); }
+
+  ref num(const token &t) {
+    uint64_t v = t._num;
+    return _t.make(kind::num, ref(v), ref(v >> 32));
+  }
+
+  ref var() {
+    next();
+    ref id = ident(take());
+    ref init = nil;
+    if (more()) {
+      take();
+      init = num(take());
+    }
+    return _t.make(kind::decl, id, init);
+  }
+
+  ref block() {
+    next();
+    ref head = nil, last = nil;
+    link(head, last, stmt());
+    while (more()) {
+      link(head, last, stmt());
+    }
+    return head;
+  }
+
+  ref stmt() {
+    symtab::id which = _g.rhs(next())[0]._id;
+    size_t r = next();
+    if (which == _if || which == _while) {
+      // Keywords are taken wherever the rule has them, so a grammar may
+      // add one, like `do` after the condition.
+      ref parts[3] = {nil, nil, nil};
+      size_t n = 0;
+      grammar::span body = _g.rhs(r);
+      for (size_t i = 0; i < body.size(); ++i) {
+        if (body[i]._term) {
+          take();
+        } else {
+          parts[n] = n == 0 ? boolExp() : n == 1 ? block() : elseBlock();
+          ++n;
+        }
+      }
+      return _t.make(which == _if ? kind::ifStmt : kind::whileStmt, parts[0],
+                     parts[1], parts[2]);
+    }
+    token first = take();
+    if (which == _print) {
+      ref head = nil, last = nil;
+      link(head, last, boolExp());
+      while (more()) {
+        take();
+        link(head, last, boolExp());
+      }
+      return _t.make(kind::print, head);
+    }
+    ref id = ident(first);
+    take();
+    return _t.make(kind::assign, id, boolExp());
+  }
+
+  ref elseBlock() {
+    ref b = nil;
+    grammar::span body = _g.rhs(next());
+    for (size_t i = 0; i < body.size(); ++i) {
+      if (body[i]._term) {
+        take();
+      } else {
+        b = block();
+      }
+    }
+    return b;
+  }
+
+  ref boolExp() {
+    next();
+    ref l = boolTerm();
+    for (size_t r = next(); !_g.rhs(r).empty(); r = next()) {
+      op(r);
+      l = _t.make(kind::lor, l, boolTerm());
+    }
+    return l;
+  }
+
+  ref boolTerm() {
+    next();
+    ref l = notFactor();
+    for (size_t r = next(); !_g.rhs(r).empty(); r = next()) {
+      op(r);
+      l = _t.make(kind::land, l, notFactor());
+    }
+    return l;
+  }
+
+  ref notFactor() {
+    next();
+    bool negate = more();
+    if (negate) {
+      take();
+    }
+    ref r = relation();
+    return negate ? _t.make(kind::lnot, r) : r;
+  }
+
+  ref relation() {
+    next();
+    return binary(&builder::exp);
+  }
+
+  ref exp() {
+    next();
+    return binary(&builder::term);
+  }
+
+  ref term() {
+    next();
+    return binary(&builder::factor);
+  }
+
+  // operand (op operand)*.
+  ref binary(ref (builder::*operand)()) {
+    ref l = (this->*operand)();
+    for (size_t r = next(); !_g.rhs(r).empty(); r = next()) {
+      kind k = _ops[op(r)._sym];
+      l = _t.make(k, l, (this->*operand)());
+    }
+    return l;
+  }
+
+  // The operator of a tail rule, a terminal of the rule or read by a
+  // one-terminal rule of its own.
+  token op(size_t tail) {
+    if (!_g.rhs(tail)[0]._term) {
+      next();
+    }
+    return take();
+  }
+
+  ref factor() {
+    grammar::lexem first = _g.rhs(next())[0];
+    token t = take();
+    if (first._id == _ident && first._term) {
+      return ident(t);
+    } else if (first._id == _num && first._term) {
+      return num(t);
+    }
+    ref e = exp();
+    take();
+    return e;
+  }
+};
+
+void ast::build(const grammar &gramm, const parser::trace &rules,
+                const tokbuf &tokens, const source &src) {
+  clear();
+  _src = &src;
+  _nodes.reserve(tokens.size() + 1);
+  builder(*this, gramm, rules, tokens, src).program();
+}
+
+void ast::clear() {
+  std::vector<node>().swap(_nodes);
+  _src = nullptr;
+}
+
+ast::ref ast::make(kind k, ref a, ref b, ref c) {
+  _nodes.push_back({k, a, b, c, nil});
+  return _nodes.size() - 1;
+}
+
+std::string ast::name(ref ident) const {
+  return std::string(_src->data() + _nodes[ident]._a, _nodes[ident]._b);
+}
+
+int64_t ast::value(ref num) const {
+  return int64_t(uint64_t(_nodes[num]._a) | uint64_t(_nodes[num]._b) << 32);
+}
+
+details ast::where(ref ident) const {
+  return _src->where(_nodes[ident]._a);
+}
+
+const char *ast::name(kind k) {
+  static const char *names[] = {
+      "program", "decl", "assign", "if", "while", "print", "|",
+      "&",       "!",    "<",      "<=", ">",     ">=",    "=",
+      "/=",      "+",    "-",      "*",  "/",     "ident", "num"};
+  return names[size_t(k)];
+}
+
+void ast::dump() const {
+  fmt::MemoryWriter out;
+  dump(out);
+  fwrite(out.data(), 1, out.size(), stdout);
+}
+
+void ast::dump(fmt::Writer &out) const {
+  if (root() != nil) {
+    dump(out, root(), 0);
+  }
+}
+
+void ast::dump(fmt::Writer &out, ref r, int depth) const {
+  for (; r != nil; r = _nodes[r]._next) {
+    const node &n = _nodes[r];
+    std::string indent(depth * 2, ' ');
+    out << indent << name(n._kind);
+    if (n._kind == kind::ident) {
+      out << ' ' << name(r);
+    } else if (n._kind == kind::num) {
+      out << ' ' << value(r);
+    }
+    out << '\n';
+
+    switch (n._kind) {
+    case kind::ident:
+    case kind::num:
+      break;
+    case kind::ifStmt:
+      dump(out, n._a, depth + 1);
+      dump(out, n._b, depth + 1);
+      if (n._c != nil) {
+        out << indent << "else\n";
+        dump(out, n._c, depth + 1);
+      }
+      break;
+    default:
+      dump(out, n._a, depth + 1);
+      dump(out, n._b, depth + 1);
+      break;
+    }
+  }
+}
+}
@@ -0,0 +1,109 @@
+//
+//  ast.h
+//  tiny
+//
+//  Created by Иван Дмитриевский on 18/10/26.
+//  Copyright (c) 2026 Ivan Dmitrievsky. All rights reserved.
+//
+
+#ifndef __tiny__ast__
+#define __tiny__ast__
+
+#include "format.h"
+#include "grammar.h"
+#include "parser.h"
+#include "source.h"
+#include "tokbuf.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace tiny {
+// Syntax tree of one compilation, built by replaying the rule trace over
+// the tokens. Nodes live in a single array and refer to each other by
+// 32-bit index, so a tree is one allocation and is freed in one go.
+//
+// Children by kind:
+//   program      _a first decl, _b first statement
+//   decl         _a ident, _b num or nil
+//   assign       _a ident, _b expression
+//   ifStmt       _a condition, _b first statement, _c first else statement
+//   whileStmt    _a condition, _b first statement
+//   print        _a first expression
+//   lnot         _a operand
+//   binary ops   _a left, _b right
+//   ident        _a offset in the source, _b length
+//   num          _a, _b low and high half of the value
+// Lists are chained through _next.
+class ast {
+public:
+  typedef uint32_t ref;
+  static const ref nil = UINT32_MAX;
+
+  enum class kind : uint8_t {
+    program,
+    decl,
+    assign,
+    ifStmt,
+    whileStmt,
+    print,
+    lor,
+    land,
+    lnot,
+    lt,
+    le,
+    gt,
+    ge,
+    eq,
+    ne,
+    add,
+    sub,
+    mul,
+    div,
+    ident,
+    num
+  };
+
+  struct node {
+    kind _kind;
+    ref _a;
+    ref _b;
+    ref _c;
+    ref _next;
+  };
+
+  ast() = default;
+  ast(const ast &) = delete;
+  ast &operator=(const ast &) = delete;
+
+  // Expects the trace of a successful parse of these tokens.
+  void build(const grammar &gramm, const parser::trace &rules,
+             const tokbuf &tokens, const source &src);
+  void clear();
+
+  ref root() const { return _nodes.empty() ? nil : 0; }
+  const node &operator[](ref r) const { return _nodes[r]; }
+  size_t size() const { return _nodes.size(); }
+  size_t bytes() const { return _nodes.capacity() * sizeof(node); }
+
+  std::string name(ref ident) const;
+  int64_t value(ref num) const;
+  // Line and column of an identifier.
+  details where(ref ident) const;
+  static const char *name(kind k);
+
+  void dump() const;
+  void dump(fmt::Writer &out) const;
+
+private:
+  class builder;
+
+  std::vector<node> _nodes;
+  const source *_src = nullptr;
+
+  ref make(kind k, ref a = nil, ref b = nil, ref c = nil);
+  void dump(fmt::Writer &out, ref r, int depth) const;
+};
+}
+
+#endif /* defined(__tiny__ast__) */
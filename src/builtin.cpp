@@ -0,0 +1,33 @@
+//
+//  builtin.cpp
+//  tiny
+//
+//  Created by Иван Дмитриевский on 18/10/26.
+//  Copyright (c) 2026 Ivan Dmitrievsky. All rights reserved.
+//
+
+#include "grammar.h"
+
+#include "grammar_tables.h"
+
+namespace tiny {
+grammar::grammar() {
+  tables t;
+  t._termNames = builtin::termNames;
+  t._termOffs = builtin::termOffs;
+  t._termSlots = builtin::termSlots;
+  t._terms = builtin::terms;
+  t._termSlotCount = builtin::termSlotCount;
+  t._nontermNames = builtin::nontermNames;
+  t._nontermOffs = builtin::nontermOffs;
+  t._nontermSlots = builtin::nontermSlots;
+  t._nonterms = builtin::nonterms;
+  t._nontermSlotCount = builtin::nontermSlotCount;
+  t._rules = builtin::rules;
+  t._lhs = builtin::lhs;
+  t._rhsOffs = builtin::rhsOffs;
+  t._rhs = builtin::rhs;
+  t._predicts = builtin::predicts;
+  use(t);
+}
+}
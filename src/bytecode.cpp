@@ -0,0 +1,211 @@
+//
+//  bytecode.cpp
+//  tiny
+//
+//  Created by Иван Дмитриевский on 18/10/26.
+//  Copyright (c) 2026 Ivan Dmitrievsky. All rights reserved.
+//
+
+#include "bytecode.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <unordered_map>
+
+namespace tiny {
+// Emits code for statements and expressions in one pass over the tree,
+// patching forward jumps once their target is known. Keeps track of the
+// stack height along the way to size the machine's stack.
+class bytecode::compiler {
+public:
+  compiler(bytecode &code, const ast &tree, const scope &vars)
+      : _c(code), _t(tree), _vars(vars) {}
+
+  void program() {
+    if (_t.root() != ast::nil) {
+      block(_t[_t.root()]._b);
+    }
+    emit(op::halt);
+  }
+
+private:
+  typedef ast::kind kind;
+
+  bytecode &_c;
+  const ast &_t;
+  const scope &_vars;
+  std::unordered_map<int64_t, uint32_t> _constIndex;
+  size_t _height = 0;
+
+  void block(ast::ref stmt) {
+    for (; stmt != ast::nil; stmt = _t[stmt]._next) {
+      const ast::node &n = _t[stmt];
+      switch (n._kind) {
+      case kind::assign:
+        exp(n._b);
+        emit(op::store, _vars[n._a]);
+        break;
+      case kind::ifStmt: {
+        exp(n._a);
+        size_t toElse = emit(op::jumpUnless);
+        block(n._b);
+        if (n._c == ast::nil) {
+          patch(toElse);
+          break;
+        }
+        size_t toEnd = emit(op::jump);
+        patch(toElse);
+        block(n._c);
+        patch(toEnd);
+        break;
+      }
+      case kind::whileStmt: {
+        // The condition goes after the body, so an iteration takes one
+        // jump instead of two.
+        size_t toCond = emit(op::jump);
+        size_t body = _c._code.size();
+        block(n._b);
+        patch(toCond);
+        exp(n._a);
+        emit(op::jumpIf, body);
+        break;
+      }
+      case kind::print: {
+        size_t count = 0;
+        for (ast::ref e = n._a; e != ast::nil; e = _t[e]._next, ++count) {
+          exp(e);
+        }
+        emit(op::print, count);
+        break;
+      }
+      default:
+        break;
+      }
+    }
+  }
+
+  void exp(ast::ref e) {
+    static const op binary[] = {op::lt,  op::le,  op::gt,  op::ge,
+                                op::eq,  op::ne,  op::add, op::sub,
+                                op::mul, op::div};
+    const ast::node &n = _t[e];
+    switch (n._kind) {
+    case kind::ident:
+      emit(op::load, _vars[e]);
+      break;
+    case kind::num:
+      emit(op::push, constant(_t.value(e)));
+      break;
+    case kind::lnot:
+      exp(n._a);
+      emit(op::lnot);
+      break;
+    case kind::lor:
+    case kind::land: {
+      exp(n._a);
+      size_t toEnd = emit(n._kind == kind::lor ? op::orJump : op::andJump);
+      exp(n._b);
+      emit(op::truth);
+      patch(toEnd);
+      break;
+    }
+    default:
+      exp(n._a);
+      exp(n._b);
+      emit(binary[size_t(n._kind) - size_t(kind::lt)]);
+    }
+  }
+
+  uint32_t constant(int64_t v) {
+    auto it = _constIndex.emplace(v, _c._consts.size());
+    if (it.second) {
+      _c._consts.push_back(v);
+    }
+    return it.first->second;
+  }
+
+  // Appends an instruction and returns its address.
+  size_t emit(op o, size_t arg = 0) {
+    check(arg);
+    switch (o) {
+    case op::push:
+    case op::load:
+      ++_height;
+      break;
+    case op::store:
+    case op::andJump:
+    case op::orJump:
+    case op::jumpIf:
+    case op::jumpUnless:
+      --_height;
+      break;
+    case op::print:
+      _height -= arg;
+      break;
+    case op::lnot:
+    case op::truth:
+    case op::jump:
+    case op::halt:
+      break;
+    default:
+      --_height;
+    }
+    _c._depth = std::max(_c._depth, _height);
+    _c._code.push_back(uint32_t(o) | uint32_t(arg) << 8);
+    return _c._code.size() - 1;
+  }
+
+  // Points the jump at `at` to the next instruction.
+  void patch(size_t at) {
+    size_t target = _c._code.size();
+    check(target);
+    _c._code[at] |= uint32_t(target) << 8;
+  }
+
+  void check(size_t arg) const {
+    if (arg > maxArg) {
+      fmt::printf("Program is too large for bytecode\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+};
+
+bytecode::bytecode(const ast &tree, const scope &vars) : _init(vars.init()) {
+  compiler(*this, tree, vars).program();
+}
+
+void bytecode::dump(fmt::Writer &out) const {
+  for (size_t i = 0; i < _code.size(); ++i) {
+    op o = code(_code[i]);
+    out.write("{:5}  {}", i, name(o));
+    switch (o) {
+    case op::push:
+      out << ' ' << _consts[arg(_code[i])];
+      break;
+    case op::load:
+    case op::store:
+    case op::andJump:
+    case op::orJump:
+    case op::jump:
+    case op::jumpIf:
+    case op::jumpUnless:
+    case op::print:
+      out << ' ' << arg(_code[i]);
+      break;
+    default:
+      break;
+    }
+    out << '\n';
+  }
+}
+
+const char *bytecode::name(op o) {
+  static const char *names[] = {
+      "push",        "load",        "store",       "add",         "sub",
+      "mul",         "div",         "lt",          "le",          "gt",
+      "ge",          "eq",          "ne",          "not",         "truth",
+      "and-jump",    "or-jump",     "jump",        "jump-if",     "jump-unless",
+      "print",       "halt"};
+  return names[size_t(o)];
+}
+}
@@ -0,0 +1,82 @@
+//
+//  bytecode.h
+//  tiny
+//
+//  Created by Иван Дмитриевский on 18/10/26.
+//  Copyright (c) 2026 Ivan Dmitrievsky. All rights reserved.
+//
+
+#ifndef __tiny__bytecode__
+#define __tiny__bytecode__
+
+#include "ast.h"
+#include "format.h"
+#include "scope.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace tiny {
+// A program compiled for the stack machine in vm.h. Instructions are
+// 32-bit words in one array, the opcode in the low byte and an unsigned
+// 24-bit argument above it: a slot, an index into the constants, a jump
+// target or a count of values.
+class bytecode {
+public:
+  enum class op : uint8_t {
+    push,       // constant arg
+    load,       // slot arg
+    store,      // pops into slot arg
+    add,
+    sub,
+    mul,
+    div,
+    lt,
+    le,
+    gt,
+    ge,
+    eq,
+    ne,
+    lnot,
+    truth,      // 1 for any nonzero top
+    andJump,    // to arg keeping a zero top, pops it otherwise
+    orJump,     // to arg making a nonzero top 1, pops it otherwise
+    jump,
+    jumpIf,     // pops, jumps if nonzero
+    jumpUnless, // pops, jumps if zero
+    print,      // pops and prints arg values, deepest first
+    halt
+  };
+  static const size_t ops = size_t(op::halt) + 1;
+  static const uint32_t maxArg = (1 << 24) - 1;
+
+  // Exits when the program needs an argument above maxArg.
+  bytecode(const ast &tree, const scope &vars);
+
+  bytecode(const bytecode &) = delete;
+  bytecode &operator=(const bytecode &) = delete;
+
+  static op code(uint32_t ins) { return op(ins & 0xff); }
+  static uint32_t arg(uint32_t ins) { return ins >> 8; }
+
+  const std::vector<uint32_t> &code() const { return _code; }
+  const std::vector<int64_t> &consts() const { return _consts; }
+  // Initial values by slot.
+  const std::vector<int64_t> &init() const { return _init; }
+  // Most values the program ever has on the stack.
+  size_t depth() const { return _depth; }
+
+  void dump(fmt::Writer &out) const;
+  static const char *name(op o);
+
+private:
+  class compiler;
+
+  std::vector<uint32_t> _code;
+  std::vector<int64_t> _consts;
+  std::vector<int64_t> _init;
+  size_t _depth = 0;
+};
+}
+
+#endif /* defined(__tiny__bytecode__) */
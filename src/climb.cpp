@@ -0,0 +1,329 @@
+//
+//  climb.cpp
+//  tiny
+//
+//  Created by Иван Дмитриевский on 18/10/26.
+//  Copyright (c) 2026 Ivan Dmitrievsky. All rights reserved.
+//
+
+#include "parser.h"
+#include "format.h"
+
+namespace tiny {
+const size_t parser::climb::steps;
+
+// After an operand every binary step from the base down to term has its
+// tail pending. An operator closes the tighter tails and reopens them with
+// the next operand, so no symbol stack is needed, only recursion for
+// parentheses. Decisions still go through the predict table: the rules
+// emitted and the errors reported are those of the table loop.
+template <class Tokens> class parser::climber {
+public:
+  climber(parser &p, Tokens &tokens, const token *&tok, symtab::id &sym,
+          trace &out)
+      : _p(p), _c(p._climb), _tokens(tokens), _tok(tok), _sym(sym),
+        _out(out), _trace(p._exprTrace) {}
+
+  bool expr(climb::step base) { return open(base) && tails(base); }
+
+private:
+  parser &_p;
+  const climb &_c;
+  Tokens &_tokens;
+  const token *&_tok;
+  symtab::id &_sym;
+  trace &_out;
+  bool _trace;
+
+  void emit(size_t rule) {
+    if (_trace) {
+      _out.push_back(rule);
+    }
+  }
+
+  void advance() {
+    _tokens.advance();
+    _tok = _tokens.done() ? nullptr : &_tokens.peek();
+    _sym = _tok ? _tok->_sym : symtab::none;
+  }
+
+  bool eof(grammar::lexem l) {
+    _p._eoferror(l);
+    return false;
+  }
+
+  bool predict(symtab::id nt, size_t &rule) {
+    if (!_tok) {
+      return eof({nt, false});
+    }
+    bool found = false;
+    rule = _p._gramm.predict(nt, _sym, found);
+    if (!found) {
+      _p._gerror({nt, false}, *_tok, _tokens.src());
+    }
+    return found;
+  }
+
+  bool match(symtab::id t) {
+    if (!_tok) {
+      return eof({t, true});
+    }
+    if (_sym != t) {
+      _p._serror({t, true}, _tok->val(_tokens.src()),
+                 _tokens.src().where(_tok->_off));
+      return false;
+    }
+    advance();
+    return true;
+  }
+
+  bool open(climb::step s) {
+    if (_tok && _sym < _c._plain.size() && _c._plain[_sym]) {
+      if (_trace) {
+        _out.insert(_out.end(), _c._chain[s].begin(), _c._chain[s].end());
+      }
+      return factor();
+    }
+
+    size_t rule;
+    for (; s < climb::factor; s = climb::step(s + 1)) {
+      if (!predict(_c._nt[s], rule)) {
+        return false;
+      }
+      emit(rule);
+      if (s == climb::notFactor) {
+        if (!predict(_c._notOpt, rule)) {
+          return false;
+        }
+        emit(rule);
+        for (auto sym : _p._gramm.rhs(rule)) {
+          if (!match(grammar::decode(sym)._id)) {
+            return false;
+          }
+        }
+      }
+    }
+    return factor();
+  }
+
+  bool factor() {
+    size_t rule;
+    if (!predict(_c._nt[climb::factor], rule)) {
+      return false;
+    }
+    emit(rule);
+    for (auto sym : _p._gramm.rhs(rule)) {
+      grammar::lexem l = grammar::decode(sym);
+      if (l._term ? !match(l._id) : !expr(step(l._id))) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  void ends(int from, int to) {
+    if (_trace) {
+      for (int s = from; s >= to; --s) {
+        if (_c._tail[s] != symtab::none) {
+          _out.push_back(_c._end[s]);
+        }
+      }
+    }
+  }
+
+  bool tails(climb::step base) {
+    size_t rule;
+    for (int s = climb::term; s >= int(base);) {
+      int at = _tok && s == climb::term && _sym < _c._opStep.size()
+                   ? _c._opStep[_sym]
+                   : int(climb::slow);
+      if (at == climb::closes || (at >= 0 && at < int(base))) {
+        ends(s, base);
+        return true;
+      } else if (at >= 0) {
+        ends(s, at + 1);
+        emit(_c._more[at]);
+        emit(_c._opRule[_sym]);
+        advance();
+        if (!open(_c._operand[at])) {
+          return false;
+        }
+        continue;
+      }
+
+      symtab::id tail = _c._tail[s];
+      if (tail == symtab::none) {
+        --s;
+        continue;
+      }
+      if (!predict(tail, rule)) {
+        return false;
+      }
+      emit(rule);
+      grammar::span body = _p._gramm.rhs(rule);
+      if (body.empty()) {
+        --s;
+        continue;
+      }
+
+      grammar::lexem op = body[0];
+      if (op._term) {
+        if (!match(op._id)) {
+          return false;
+        }
+      } else {
+        if (!predict(op._id, rule)) {
+          return false;
+        }
+        emit(rule);
+        for (auto sym : _p._gramm.rhs(rule)) {
+          if (!match(grammar::decode(sym)._id)) {
+            return false;
+          }
+        }
+      }
+      if (!open(_c._operand[s])) {
+        return false;
+      }
+      s = climb::term;
+    }
+    return true;
+  }
+
+  climb::step step(symtab::id nt) const {
+    for (size_t s = 0; s < climb::steps; ++s) {
+      if (_c._nt[s] == nt) {
+        return climb::step(s);
+      }
+    }
+    return climb::boolExp;
+  }
+};
+
+template <class Tokens>
+bool parser::_expr(Tokens &tokens, const token *&tok, symtab::id &sym,
+                   trace &out) {
+  climber<Tokens> c(*this, tokens, tok, sym, out);
+  return c.expr(climb::boolExp);
+}
+
+template bool parser::_expr(lex &, const token *&, symtab::id &, trace &);
+template bool parser::_expr(tokbuf::cursor &, const token *&, symtab::id &,
+                            trace &);
+
+bool parser::_setupClimb() {
+  static const struct {
+    const char *_nt;
+    const char *_tail;
+    climb::step _operand;
+  } shape[] = {{"bool-exp", "bool-exp-tail", climb::boolTerm},
+               {"bool-term", "bool-term-tail", climb::notFactor},
+               {"not-factor", nullptr, climb::relation},
+               {"relation", "relation-tail", climb::exp},
+               {"exp", "exp-tail", climb::term},
+               {"term", "term-tail", climb::factor},
+               {"factor", nullptr, climb::factor}};
+
+  for (size_t s = 0; s < climb::steps; ++s) {
+    _climb._nt[s] = _gramm.mnt(shape[s]._nt)._id;
+    _climb._tail[s] =
+        shape[s]._tail ? _gramm.mnt(shape[s]._tail)._id : symtab::none;
+    _climb._operand[s] = shape[s]._operand;
+    if (_climb._nt[s] == symtab::none ||
+        (shape[s]._tail && _climb._tail[s] == symtab::none)) {
+      return false;
+    }
+  }
+  _climb._notOpt = _gramm.mnt("not-factor-opt")._id;
+  if (_climb._notOpt == symtab::none) {
+    return false;
+  }
+
+  // Every non-empty tail rule must read `op operand tail`.
+  for (size_t r = 0; r < _gramm.rules(); ++r) {
+    for (size_t s = 0; s < climb::steps; ++s) {
+      grammar::span body = _gramm.rhs(r);
+      if (_gramm.lhs(r)._id != _climb._tail[s] || body.empty()) {
+        continue;
+      }
+      if (body.size() != 3 ||
+          body[1]._id != _climb._nt[_climb._operand[s]] || body[1]._term ||
+          body[2]._id != _climb._tail[s] || body[2]._term) {
+        return false;
+      }
+    }
+  }
+
+  // A terminal starts a plain operand when every step down to factor
+  // predicts the same rules for it, with an empty not-factor-opt.
+  size_t terms = _gramm.terms().size();
+  _climb._plain.assign(terms, false);
+  std::vector<uint8_t> chain;
+  for (size_t t = 0; t < terms; ++t) {
+    std::vector<uint8_t> rules;
+    bool plain = true;
+    for (size_t s = 0; s < climb::factor && plain; ++s) {
+      size_t rule = _gramm.predict(_climb._nt[s], t, plain);
+      rules.push_back(rule);
+      if (plain && s == climb::notFactor) {
+        rule = _gramm.predict(_climb._notOpt, t, plain);
+        plain = plain && _gramm.rhs(rule).empty();
+        rules.push_back(rule);
+      }
+    }
+    bool operand = false;
+    _gramm.predict(_climb._nt[climb::factor], t, operand);
+    if (plain && operand && (chain.empty() || chain == rules)) {
+      chain = rules;
+      _climb._plain[t] = true;
+    }
+  }
+
+  for (size_t s = 0, at = 0; s < climb::steps; ++s) {
+    _climb._chain[s].assign(chain.begin() + std::min(at, chain.size()),
+                            chain.end());
+    at += s == climb::notFactor ? 2 : 1;
+  }
+
+  for (size_t r = 0; r < _gramm.rules(); ++r) {
+    for (size_t s = 0; s < climb::steps; ++s) {
+      if (_gramm.lhs(r)._id == _climb._tail[s]) {
+        (_gramm.rhs(r).empty() ? _climb._end : _climb._more)[s] = r;
+      }
+    }
+  }
+
+  // Operators are terminals predicted by one tail after the tighter ones
+  // ended, with the operator nonterminal reading just that terminal.
+  _climb._opStep.assign(terms, climb::slow);
+  _climb._opRule.assign(terms, 0);
+  for (size_t t = 0; t < terms; ++t) {
+    int8_t at = climb::closes;
+    for (int s = climb::term; s >= 0 && at == climb::closes; --s) {
+      if (_climb._tail[s] == symtab::none) {
+        continue;
+      }
+      bool found = false;
+      size_t rule = _gramm.predict(_climb._tail[s], t, found);
+      if (!found) {
+        at = climb::slow;
+      } else if (!_gramm.rhs(rule).empty()) {
+        grammar::lexem op = _gramm.rhs(rule)[0];
+        if (op._term) {
+          at = climb::slow;
+        } else {
+          size_t opRule = _gramm.predict(op._id, t, found);
+          bool single = found && _gramm.rhs(opRule).size() == 1 &&
+                        _gramm.rhs(opRule)[0]._term;
+          at = single ? s : climb::slow;
+          if (single) {
+            _climb._opRule[t] = opRule;
+          }
+        }
+      }
+    }
+    _climb._opStep[t] = at;
+  }
+  return true;
+}
+}
@@ -0,0 +1,79 @@
+//
+//  descent.cpp
+//  tiny
+//
+//  Created by Иван Дмитриевский on 18/10/26.
+//  Copyright (c) 2026 Ivan Dmitrievsky. All rights reserved.
+//
+
+#include "parser.h"
+#include "format.h"
+
+#include "descent_rules.h"
+
+namespace tiny {
+// What the generated functions call back into. Mirrors the table loop
+// step for step, so traces and error messages are the same.
+template <class Tokens> class parser::driver {
+public:
+  driver(parser &p, Tokens &tokens, trace &out)
+      : _p(p), _tokens(tokens), _rules(out) {
+    load();
+  }
+
+  bool more() const { return _token != nullptr; }
+  symtab::id sym() const { return _sym; }
+  void rule(size_t num) { _rules.push_back(num); }
+
+  bool term(symtab::id t) {
+    if (!_token) {
+      return eof({t, true});
+    }
+    if (_sym != t) {
+      _p._serror({t, true}, _token->val(_tokens.src()),
+                 _tokens.src().where(_token->_off));
+      return false;
+    }
+    _tokens.advance();
+    load();
+    return true;
+  }
+
+  bool fail(symtab::id nt) {
+    _p._gerror({nt, false}, *_token, _tokens.src());
+    return false;
+  }
+
+  bool eof(symtab::id nt) { return eof({nt, false}); }
+
+  bool eof(grammar::lexem l) {
+    _p._eoferror(l);
+    return false;
+  }
+
+private:
+  parser &_p;
+  Tokens &_tokens;
+  const token *_token = nullptr;
+  symtab::id _sym = symtab::none;
+  trace &_rules;
+
+  void load() {
+    _token = _tokens.done() ? nullptr : &_tokens.peek();
+    _sym = _token ? _token->_sym : symtab::none;
+  }
+};
+
+bool parser::_generatedFor(const grammar &gramm) {
+  return gramm.fingerprint() == generated::fingerprint;
+}
+
+template <class Tokens> bool parser::_descend(Tokens &tokens, trace &out) {
+  out.clear();
+  driver<Tokens> d(*this, tokens, out);
+  return generated::descent<driver<Tokens>>::start(d);
+}
+
+template bool parser::_descend(lex &, trace &);
+template bool parser::_descend(tokbuf::cursor &, trace &);
+}
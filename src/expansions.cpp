@@ -0,0 +1,66 @@
+//
+//  expansions.cpp
+//  tiny
+//
+//  Created by Иван Дмитриевский on 18/10/26.
+//  Copyright (c) 2026 Ivan Dmitrievsky. All rights reserved.
+//
+
+#include "expansions.h"
+
+namespace tiny {
+expansions::expansions(const grammar &gramm, symtab::id keep)
+    : _terms(gramm.terms().size()),
+      _cells(gramm.nonterms().size() * _terms) {
+  std::vector<uint16_t> front;
+  for (symtab::id nt = 0; nt < gramm.nonterms().size(); ++nt) {
+    for (symtab::id t = 0; t < _terms; ++t) {
+      cell &c = _cells[nt * _terms + t];
+      c._rules = _rules.size();
+      front.clear();
+      front.push_back(nt);
+
+      // Expand the leftmost symbol for as long as the table decides it
+      // from this lookahead alone.
+      while (!front.empty() && _rules.size() - c._rules < UINT16_MAX) {
+        grammar::lexem l = grammar::decode(front.back());
+        if (l._term) {
+          if (l._id == t) {
+            front.pop_back();
+            c._match = true;
+          }
+          break;
+        }
+        bool found = false;
+        size_t rule = gramm.predict(l._id, t, found);
+        if (!found || (l._id == keep && l._id != nt)) {
+          break;
+        }
+        _rules.push_back(rule);
+        front.pop_back();
+        grammar::span body = gramm.rhs(rule);
+        for (const uint16_t *it = body.end(); it != body.begin();) {
+          front.push_back(*--it);
+        }
+      }
+
+      c._ruleCount = _rules.size() - c._rules;
+      if (c._ruleCount == 0) {
+        c = cell();
+        continue;
+      }
+      c._push = _push.size();
+      c._pushCount = front.size();
+      _push.insert(_push.end(), front.begin(), front.end());
+    }
+  }
+}
+
+double expansions::fold() const {
+  size_t predicted = 0;
+  for (auto &c : _cells) {
+    predicted += c._ruleCount != 0;
+  }
+  return predicted ? double(_rules.size()) / predicted : 0;
+}
+}
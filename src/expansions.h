@@ -0,0 +1,61 @@
+//
+//  expansions.h
+//  tiny
+//
+//  Created by Иван Дмитриевский on 18/10/26.
+//  Copyright (c) 2026 Ivan Dmitrievsky. All rights reserved.
+//
+
+#ifndef __tiny__expansions__
+#define __tiny__expansions__
+
+#include "grammar.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace tiny {
+// The table loop's work between two input symbols, done once at load time.
+// For a nonterminal on top of the stack and a lookahead, the expansion is
+// every rule the loop would apply until the lookahead is matched or an
+// empty rule hands the choice to whatever lies below on the stack: unit
+// rules, rules reading a single terminal and empty prefixes such as
+// not-factor-opt are folded into one step. Rules keep their numbers, so
+// the trace is unchanged; where a later symbol has no prediction the
+// expansion stops in front of it and the loop reports the error as before.
+class expansions {
+public:
+  struct cell {
+    uint32_t _rules = 0;
+    uint32_t _push = 0;
+    // No rules: the table has no prediction for the pair.
+    uint16_t _ruleCount = 0;
+    uint16_t _pushCount = 0;
+    // Ends by matching the lookahead, the caller advances.
+    bool _match = false;
+  };
+
+  // keep is left on the stack when it comes up inside an expansion, for
+  // engines that take that nonterminal over.
+  explicit expansions(const grammar &gramm, symtab::id keep = symtab::none);
+
+  const cell &at(symtab::id nt, symtab::id t) const {
+    return t < _terms ? _cells[nt * _terms + t] : _none;
+  }
+  // Rules of c, then its symbols in stack order, leftmost last.
+  const uint8_t *rules(const cell &c) const { return &_rules[c._rules]; }
+  const uint16_t *push(const cell &c) const { return &_push[c._push]; }
+
+  // Rules per expansion, averaged over the predicted pairs.
+  double fold() const;
+
+private:
+  size_t _terms;
+  std::vector<cell> _cells;
+  std::vector<uint8_t> _rules;
+  std::vector<uint16_t> _push;
+  cell _none;
+};
+}
+
+#endif /* defined(__tiny__expansions__) */
@@ -0,0 +1,38 @@
+//
+//  fdwriter.cpp
+//  tiny
+//
+//  Created by Иван Дмитриевский on 18/10/26.
+//  Copyright (c) 2026 Ivan Dmitrievsky. All rights reserved.
+//
+
+#include "fdwriter.h"
+
+#include <cerrno>
+#include <cstring>
+
+#include <unistd.h>
+
+namespace tiny {
+const size_t fdwriter::chunk;
+
+void fdwriter::flush() {
+  write(_fd, _buf.data(), _buf.size());
+  _buf.clear();
+}
+
+void fdwriter::write(int fd, const char *data, size_t size) {
+  while (size > 0) {
+    ssize_t n = ::write(fd, data, size);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      fmt::printf("Cannot write output: %s\n", strerror(errno));
+      exit(EXIT_FAILURE);
+    }
+    data += n;
+    size -= n;
+  }
+}
+}
@@ -0,0 +1,47 @@
+//
+//  fdwriter.h
+//  tiny
+//
+//  Created by Иван Дмитриевский on 18/10/26.
+//  Copyright (c) 2026 Ivan Dmitrievsky. All rights reserved.
+//
+
+#ifndef __tiny__fdwriter__
+#define __tiny__fdwriter__
+
+#include "format.h"
+
+#include <cstddef>
+
+namespace tiny {
+// Output formatted into memory and handed to a file descriptor in large
+// chunks with write(2), bypassing stdio. Callers format into out() and
+// call spill() now and then.
+class fdwriter {
+public:
+  static const size_t chunk = 1 << 16;
+
+  explicit fdwriter(int fd) : _fd(fd) {}
+  ~fdwriter() { flush(); }
+
+  fdwriter(const fdwriter &) = delete;
+  fdwriter &operator=(const fdwriter &) = delete;
+
+  fmt::Writer &out() { return _buf; }
+  void spill() {
+    if (_buf.size() >= chunk) {
+      flush();
+    }
+  }
+  void flush();
+
+  // All of data, retrying short writes; exits when the fd refuses it.
+  static void write(int fd, const char *data, size_t size);
+
+private:
+  int _fd;
+  fmt::MemoryWriter _buf;
+};
+}
+
+#endif /* defined(__tiny__fdwriter__) */
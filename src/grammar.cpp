@@ -8,96 +8,456 @@
 
 #include "grammar.h"
 
+#include "analysis.h"
+
+#include "format.h"
 #include "json11.h"
 
+#include <algorithm>
+#include <cstring>
 #include <fstream>
-#include <streambuf>
 
 namespace tiny {
-grammar::grammar(std::string pathToGrammar, std::string pathToParseTable) {
-  std::fstream stream;
-  stream.open(pathToGrammar);
+const uint32_t grammar::version;
+const uint16_t grammar::termBit;
+
+struct grammar::header {
+  char _magic[8];
+  uint32_t _version;
+  uint32_t _byteOrder;
+  uint32_t _terms;
+  uint32_t _termSlots;
+  uint32_t _nonterms;
+  uint32_t _nontermSlots;
+  uint32_t _rules;
+  uint32_t _rhs;
+};
+
+namespace {
+const char magic[8] = {'t', 'i', 'n', 'y', 'g', 'r', 'a', 'm'};
+const uint32_t byteOrder = 0x01020304;
+
+template <class T> void put(std::string &img, const T *data, size_t count) {
+  img.append(reinterpret_cast<const char *>(data), count * sizeof(T));
+  img.resize((img.size() + 3) & ~size_t(3), '\0');
+}
+
+// An rhs array may be empty, so every array gets one spare element.
+template <class T>
+void array(fmt::MemoryWriter &out, const char *type, const char *name,
+           const T *data, size_t count) {
+  out << "constexpr " << type << " " << name << "[] = {";
+  for (size_t i = 0; i < count; ++i) {
+    out << (i % 12 ? " " : "\n    ") << unsigned(data[i]) << ",";
+  }
+  out << "\n    0};\n";
+}
+
+// 64-bit FNV-1a.
+void mix(uint64_t &h, const void *data, size_t size) {
+  const unsigned char *p = static_cast<const unsigned char *>(data);
+  for (size_t i = 0; i < size; ++i) {
+    h = (h ^ p[i]) * 1099511628211u;
+  }
+}
+
+void mix(uint64_t &h, const symtab &tab) {
+  for (size_t i = 0; i < tab.size(); ++i) {
+    mix(h, tab.name(i), strlen(tab.name(i)) + 1);
+  }
+}
+
+// Spelled like the words the lexer reads: a letter or '_', then letters,
+// digits and '_'.
+bool wordLike(const char *s) {
+  auto letter = [](char c) {
+    return ('a' <= c && c <= 'z') || ('A' <= c && c <= 'Z') || c == '_';
+  };
+  if (!letter(*s)) {
+    return false;
+  }
+  for (++s; *s; ++s) {
+    if (!letter(*s) && !('0' <= *s && *s <= '9')) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void names(fmt::MemoryWriter &out, const char *name, const symtab &tab) {
+  out << "constexpr char " << name << "[] =";
+  for (size_t i = 0; i < tab.size(); ++i) {
+    out << "\n    \"";
+    for (const char *c = tab.name(i); *c; ++c) {
+      if (*c == '"' || *c == '\\') {
+        out << '\\';
+      }
+      out << *c;
+    }
+    out << "\\0\"";
+  }
+  out << "\n    \"\";\n";
+}
+
+// Offsets start at 0 and go up to the size of the names, and every name
+// ends in a '\0'.
+bool named(const char *names, const uint32_t *offs, size_t count) {
+  if (offs[0] != 0) {
+    return false;
+  }
+  for (size_t i = 0; i < count; ++i) {
+    if (offs[i + 1] <= offs[i] || offs[i + 1] > offs[count] ||
+        names[offs[i + 1] - 1] != '\0') {
+      return false;
+    }
+  }
+  return true;
+}
+
+// The mask probe needs a power of two number of slots, and stops only at
+// an empty one.
+bool probed(const symtab::id *slots, size_t slotCount, size_t count) {
+  if (slotCount == 0 || (slotCount & (slotCount - 1)) != 0) {
+    return false;
+  }
+  size_t empty = 0;
+  for (size_t i = 0; i < slotCount; ++i) {
+    if (slots[i] == symtab::none) {
+      ++empty;
+    } else if (slots[i] >= count) {
+      return false;
+    }
+  }
+  return empty > 0;
+}
+
+bool found(const symtab &tab) {
+  for (size_t i = 0; i < tab.size(); ++i) {
+    if (tab.find(tab.name(i)) != i) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void bad(const std::string &path) {
+  fmt::printf("%s is a bad grammar image\n", path);
+  exit(EXIT_FAILURE);
+}
+
+class reader {
+public:
+  explicit reader(const source &img) : _img(img) {}
+
+  template <class T> const T *take(size_t count) {
+    size_t bytes = (count * sizeof(T) + 3) & ~size_t(3);
+    if (_img.size() - _at < bytes) {
+      fmt::printf("Grammar image is truncated\n");
+      exit(EXIT_FAILURE);
+    }
+    const T *p = reinterpret_cast<const T *>(_img.data() + _at);
+    _at += bytes;
+    return p;
+  }
+
+private:
+  const source &_img;
+  size_t _at = 0;
+};
+}
+
+grammar::grammar(const std::string &path) : _image(new source(path)) {
+  if (_image->size() >= sizeof(magic) &&
+      memcmp(_image->data(), magic, sizeof(magic)) == 0) {
+    map(path);
+  } else {
+    load(std::string(_image->data(), _image->size()));
+    _image.reset();
+  }
+  // The lexer turns every word and number into these.
+  for (const char *t : {"ident", "num"}) {
+    if (_terms.find(t) == symtab::none) {
+      fmt::printf("Grammar %s has no terminal %s\n", path, t);
+      exit(EXIT_FAILURE);
+    }
+  }
+}
 
-  std::string err, doc((std::istreambuf_iterator<char>(stream)),
-                       std::istreambuf_iterator<char>());
+void grammar::load(const std::string &doc) {
+  std::string err;
   json11::Json grammDesc = json11::Json::parse(doc, err);
+  if (!err.empty()) {
+    fmt::printf("Grammar is not valid JSON: %s\n", err);
+    exit(EXIT_FAILURE);
+  }
 
+  _ownRhsOffs.push_back(0);
   if (grammDesc.is_array()) {
     for (auto rule : grammDesc.array_items()) {
       if (rule.is_object()) {
         for (auto obj : rule.object_items()) {
-          _rules.push_back({mnt(obj.first), {}});
+          _ownLhs.push_back(_nonterms.intern(obj.first));
           if (obj.second.is_array()) {
             for (auto word : obj.second.array_items()) {
               if (word.is_string()) {
-                grammar::lexem grammLexem;
                 std::string str = word.string_value();
-                if (str[0] == '`') {
-                  grammLexem = mt(str.substr(1));
+                if (str == "`") {
+                  continue;
+                } else if (str[0] == '`') {
+                  _ownRhs.push_back(_terms.intern(str.substr(1)) | termBit);
                 } else {
-                  grammLexem = mnt(str);
+                  _ownRhs.push_back(_nonterms.intern(str));
                 }
-                _rules[_rules.size() - 1].second.push_back(grammLexem);
               }
             }
           }
+          _ownRhsOffs.push_back(_ownRhs.size());
         }
       }
     }
   }
 
-  stream.close();
-  stream.open(pathToParseTable);
-  doc = std::string((std::istreambuf_iterator<char>(stream)),
-                    std::istreambuf_iterator<char>());
-  json11::Json tableDesc = json11::Json::parse(doc, err);
+  if (_ownLhs.empty()) {
+    fmt::printf("Grammar has no rules\n");
+    exit(EXIT_FAILURE);
+  }
 
-  if (tableDesc.is_object()) {
-    for (auto pairs : tableDesc.object_items()) {
-      if (pairs.second.is_array()) {
-        for (auto pair : pairs.second.array_items()) {
-          for (auto ruleMap : pair.object_items()) {
-            _predicts.insert(
-                {{pairs.first, ruleMap.first}, ruleMap.second.int_value() - 1});
-          }
-        }
-      }
+  if (_ownLhs.size() >= UINT8_MAX) {
+    fmt::printf("Grammar has %d rules, at most %d are supported\n",
+                _ownLhs.size(), UINT8_MAX - 1);
+    exit(EXIT_FAILURE);
+  }
+
+  if (_terms.size() >= UINT8_MAX) {
+    fmt::printf("Grammar has %d terminals, at most %d are supported\n",
+                _terms.size(), UINT8_MAX - 1);
+    exit(EXIT_FAILURE);
+  }
+
+  // Symbol ids at termBit and above would read as terminals.
+  if (_nonterms.size() >= termBit) {
+    fmt::printf("Grammar has %d nonterminals, at most %d are supported\n",
+                _nonterms.size(), termBit - 1);
+    exit(EXIT_FAILURE);
+  }
+
+  _ruleCount = _ownLhs.size();
+  _lhs = _ownLhs.data();
+  _rhsOffs = _ownRhsOffs.data();
+  _rhs = _ownRhs.data();
+
+  analysis a(*this);
+  if (!a.ll1()) {
+    a.report();
+    exit(EXIT_FAILURE);
+  }
+  _ownPredicts = a.predicts();
+  _predicts = _ownPredicts.data();
+}
+
+void grammar::map(const std::string &path) {
+  reader img(*_image);
+  const header *h = img.take<header>(1);
+  if (h->_byteOrder != byteOrder) {
+    fmt::printf("%s is not a grammar image\n", path);
+    exit(EXIT_FAILURE);
+  }
+  if (h->_version != version) {
+    fmt::printf("Grammar image %s has version %d, expected %d\n", path,
+                h->_version, version);
+    exit(EXIT_FAILURE);
+  }
+
+  // Everything below is used in place, so nothing is trusted.
+  if (h->_rules == 0 || h->_rules >= UINT8_MAX || h->_terms >= UINT8_MAX ||
+      h->_nonterms >= termBit) {
+    bad(path);
+  }
+
+  tables t;
+  t._terms = h->_terms;
+  t._termSlotCount = h->_termSlots;
+  t._nonterms = h->_nonterms;
+  t._nontermSlotCount = h->_nontermSlots;
+  t._rules = h->_rules;
+  t._termOffs = img.take<uint32_t>(t._terms + 1);
+  t._nontermOffs = img.take<uint32_t>(t._nonterms + 1);
+  t._rhsOffs = img.take<uint32_t>(t._rules + 1);
+  t._termSlots = img.take<uint16_t>(t._termSlotCount);
+  t._nontermSlots = img.take<uint16_t>(t._nontermSlotCount);
+  t._lhs = img.take<uint16_t>(t._rules);
+  t._rhs = img.take<uint16_t>(h->_rhs);
+  t._predicts = img.take<uint8_t>(t._nonterms * t._terms);
+  t._termNames = img.take<char>(t._termOffs[t._terms]);
+  t._nontermNames = img.take<char>(t._nontermOffs[t._nonterms]);
+
+  if (!named(t._termNames, t._termOffs, t._terms) ||
+      !named(t._nontermNames, t._nontermOffs, t._nonterms) ||
+      !probed(t._termSlots, t._termSlotCount, t._terms) ||
+      !probed(t._nontermSlots, t._nontermSlotCount, t._nonterms) ||
+      t._rhsOffs[0] != 0 || t._rhsOffs[t._rules] != h->_rhs) {
+    bad(path);
+  }
+  for (size_t r = 0; r < t._rules; ++r) {
+    if (t._lhs[r] >= t._nonterms || t._rhsOffs[r + 1] < t._rhsOffs[r]) {
+      bad(path);
+    }
+  }
+  for (size_t i = 0; i < h->_rhs; ++i) {
+    uint16_t s = t._rhs[i];
+    if ((s & termBit) ? (s & ~termBit) >= t._terms : s >= t._nonterms) {
+      bad(path);
     }
   }
+  // A nonterminal only predicts its own rules.
+  for (size_t i = 0; i < t._nonterms * t._terms; ++i) {
+    uint8_t cell = t._predicts[i];
+    if (cell > t._rules || (cell != 0 && t._lhs[cell - 1] != i / t._terms)) {
+      bad(path);
+    }
+  }
+
+  use(t);
+  if (!found(_terms) || !found(_nonterms)) {
+    bad(path);
+  }
+}
+
+void grammar::use(const tables &t) {
+  _terms.borrow(t._termNames, t._termOffs, t._terms, t._termSlots,
+                t._termSlotCount);
+  _nonterms.borrow(t._nontermNames, t._nontermOffs, t._nonterms,
+                   t._nontermSlots, t._nontermSlotCount);
+  _ruleCount = t._rules;
+  _lhs = t._lhs;
+  _rhsOffs = t._rhsOffs;
+  _rhs = t._rhs;
+  _predicts = t._predicts;
+}
+
+void grammar::save(const std::string &pathToImage) const {
+  header h;
+  memcpy(h._magic, magic, sizeof(magic));
+  h._version = version;
+  h._byteOrder = byteOrder;
+  h._terms = _terms.size();
+  h._termSlots = _terms.slotCount();
+  h._nonterms = _nonterms.size();
+  h._nontermSlots = _nonterms.slotCount();
+  h._rules = _ruleCount;
+  h._rhs = _rhsOffs[_ruleCount];
+
+  std::string img;
+  put(img, &h, 1);
+  put(img, _terms.offs(), _terms.size() + 1);
+  put(img, _nonterms.offs(), _nonterms.size() + 1);
+  put(img, _rhsOffs, _ruleCount + 1);
+  put(img, _terms.slots(), _terms.slotCount());
+  put(img, _nonterms.slots(), _nonterms.slotCount());
+  put(img, _lhs, _ruleCount);
+  put(img, _rhs, h._rhs);
+  put(img, _predicts, _nonterms.size() * _terms.size());
+  put(img, _terms.names(), _terms.namesSize());
+  put(img, _nonterms.names(), _nonterms.namesSize());
+
+  std::ofstream out(pathToImage, std::ios::binary | std::ios::trunc);
+  out.write(img.data(), img.size());
+  if (!out) {
+    fmt::printf("Cannot write %s\n", pathToImage);
+    exit(EXIT_FAILURE);
+  }
 }
 
-std::pair<grammar::lexem, std::vector<grammar::lexem>>
-grammar::rule(size_t num) {
-  return _rules[num];
+void grammar::emit(const std::string &pathToHeader) const {
+  fmt::MemoryWriter out;
+  out << "// Generated by tools/embed from grammar.json.\n"
+      << "// Do not edit.\n\n"
+      << "#include <cstdint>\n\n"
+      << "namespace tiny {\nnamespace builtin {\n"
+      << "constexpr uint32_t terms = " << _terms.size() << ";\n"
+      << "constexpr uint32_t termSlotCount = " << _terms.slotCount() << ";\n"
+      << "constexpr uint32_t nonterms = " << _nonterms.size() << ";\n"
+      << "constexpr uint32_t nontermSlotCount = " << _nonterms.slotCount()
+      << ";\n"
+      << "constexpr uint32_t rules = " << _ruleCount << ";\n";
+  names(out, "termNames", _terms);
+  array(out, "uint32_t", "termOffs", _terms.offs(), _terms.size() + 1);
+  array(out, "uint16_t", "termSlots", _terms.slots(), _terms.slotCount());
+  names(out, "nontermNames", _nonterms);
+  array(out, "uint32_t", "nontermOffs", _nonterms.offs(),
+        _nonterms.size() + 1);
+  array(out, "uint16_t", "nontermSlots", _nonterms.slots(),
+        _nonterms.slotCount());
+  array(out, "uint16_t", "lhs", _lhs, _ruleCount);
+  array(out, "uint32_t", "rhsOffs", _rhsOffs, _ruleCount + 1);
+  array(out, "uint16_t", "rhs", _rhs, _rhsOffs[_ruleCount]);
+  array(out, "uint8_t", "predicts", _predicts,
+        _nonterms.size() * _terms.size());
+
+  // The lexer gives ident and num to words itself, see keywords.h.
+  std::vector<const char *> words;
+  for (size_t i = 0; i < _terms.size(); ++i) {
+    const char *name = _terms.name(i);
+    if (wordLike(name) && strcmp(name, "ident") != 0 &&
+        strcmp(name, "num") != 0) {
+      words.push_back(name);
+    }
+  }
+  out << "constexpr int keyWordCount = " << words.size() << ";\n"
+      << "constexpr const char *keyWords[] = {";
+  for (const char *word : words) {
+    out << "\n    \"" << word << "\",";
+  }
+  out << "\n    nullptr};\n";
+  out << "}\n}\n";
+
+  std::ofstream file(pathToHeader, std::ios::trunc);
+  file.write(out.data(), out.size());
+  if (!file) {
+    fmt::printf("Cannot write %s\n", pathToHeader);
+    exit(EXIT_FAILURE);
+  }
 }
 
-size_t grammar::predict(std::string l, token t, bool &found) {
-  auto num = _predicts.find({l, t._val});
-  found = (num != _predicts.end());
-  return num->second;
+size_t grammar::predict(symtab::id l, symtab::id t, bool &found) const {
+  uint8_t cell = t < _terms.size() ? _predicts[l * _terms.size() + t] : 0;
+  found = (cell != 0);
+  return cell - 1;
 }
 
-std::vector<std::string> grammar::expected(std::string l) {
+std::vector<std::string> grammar::expected(symtab::id l) const {
   std::vector<std::string> exp;
-  for (auto p : _predicts) {
-    if (p.first.first == l) {
-      exp.push_back(p.first.second);
+  for (size_t t = 0; t < _terms.size(); ++t) {
+    if (_predicts[l * _terms.size() + t] != 0) {
+      exp.push_back(_terms.name(t));
     }
   }
+  std::sort(exp.begin(), exp.end());
   return exp;
 }
 
-grammar::lexem grammar::mt(std::string s) {
-  grammar::lexem l;
-  l._val = s;
-  l._term = true;
-  return l;
+uint64_t grammar::fingerprint() const {
+  uint64_t h = 14695981039346656037u;
+  uint32_t counts[] = {uint32_t(_terms.size()), uint32_t(_nonterms.size()),
+                       uint32_t(_ruleCount)};
+  mix(h, counts, sizeof(counts));
+  mix(h, _terms);
+  mix(h, _nonterms);
+  mix(h, _lhs, _ruleCount * sizeof(*_lhs));
+  mix(h, _rhsOffs, (_ruleCount + 1) * sizeof(*_rhsOffs));
+  mix(h, _rhs, _rhsOffs[_ruleCount] * sizeof(*_rhs));
+  return h;
+}
+
+const char *grammar::name(lexem l) const {
+  return l._term ? _terms.name(l._id) : _nonterms.name(l._id);
+}
+
+grammar::lexem grammar::mt(const std::string &s) const {
+  return {_terms.find(s), true};
 }
 
-grammar::lexem grammar::mnt(std::string s) {
-  grammar::lexem l;
-  l._val = s;
-  l._term = false;
-  return l;
+grammar::lexem grammar::mnt(const std::string &s) const {
+  return {_nonterms.find(s), false};
 }
 }
@@ -9,33 +9,116 @@
 #ifndef __tiny__grammar__
 #define __tiny__grammar__
 
+#include "source.h"
+#include "symtab.h"
 #include "token.h"
 
-#include <map>
+#include <cstdint>
+#include <memory>
 #include <vector>
 
 namespace tiny {
+// Rules and the predict table live in flat arrays: rule heads, offsets of
+// every rule body into one symbol array, and the nonterminal x terminal
+// matrix. They are built from the JSON rules (the predict table is derived
+// by analysis), used in place from a mapped image written by save(), or
+// taken from the tables compiled into the binary.
 class grammar {
 public:
   struct lexem {
-    std::string _val;
-    bool _term = true;
-    bool operator<(const tiny::grammar::lexem &rhs) const {
-      return _val < rhs._val;
-    }
+    symtab::id _id;
+    bool _term;
   };
 
-  grammar(std::string pathToGrammar, std::string pathToParseTable);
-  std::pair<lexem, std::vector<lexem>> rule(size_t num);
-  size_t predict(std::string l, token t, bool &found);
-  std::vector<std::string> expected(std::string l);
+  // A rule body in place: encoded symbols, terminals carry termBit.
+  class span {
+  public:
+    span(const uint16_t *begin, const uint16_t *end)
+        : _begin(begin), _end(end) {}
 
-  static lexem mt(std::string s);
-  static lexem mnt(std::string s);
+    size_t size() const { return _end - _begin; }
+    bool empty() const { return _begin == _end; }
+    lexem operator[](size_t i) const { return decode(_begin[i]); }
+    const uint16_t *begin() const { return _begin; }
+    const uint16_t *end() const { return _end; }
+
+  private:
+    const uint16_t *_begin;
+    const uint16_t *_end;
+  };
+
+  grammar();
+  explicit grammar(const std::string &path);
+
+  grammar(const grammar &) = delete;
+  grammar &operator=(const grammar &) = delete;
+
+  void save(const std::string &pathToImage) const;
+  void emit(const std::string &pathToHeader) const;
+
+  size_t rules() const { return _ruleCount; }
+  lexem lhs(size_t num) const { return {_lhs[num], false}; }
+  span rhs(size_t num) const {
+    return span(_rhs + _rhsOffs[num], _rhs + _rhsOffs[num + 1]);
+  }
+  size_t predict(symtab::id l, symtab::id t, bool &found) const;
+  std::vector<std::string> expected(symtab::id l) const;
+
+  const symtab &terms() const { return _terms; }
+  const symtab &nonterms() const { return _nonterms; }
+  const char *name(lexem l) const;
+
+  // Hash of the rules and symbol names: equal for grammars that parse
+  // alike with the same symbol and rule numbers.
+  uint64_t fingerprint() const;
+
+  lexem mt(const std::string &s) const;
+  lexem mnt(const std::string &s) const;
+
+  static lexem decode(uint16_t sym) {
+    return {symtab::id(sym & ~termBit), (sym & termBit) != 0};
+  }
 
 private:
-  std::vector<std::pair<lexem, std::vector<lexem>>> _rules;
-  std::map<std::pair<std::string, std::string>, size_t> _predicts;
+  static const uint32_t version = 1;
+  static const uint16_t termBit = 0x8000;
+  struct header;
+  struct tables {
+    const char *_termNames;
+    const uint32_t *_termOffs;
+    const uint16_t *_termSlots;
+    size_t _terms;
+    size_t _termSlotCount;
+    const char *_nontermNames;
+    const uint32_t *_nontermOffs;
+    const uint16_t *_nontermSlots;
+    size_t _nonterms;
+    size_t _nontermSlotCount;
+    size_t _rules;
+    const uint16_t *_lhs;
+    const uint32_t *_rhsOffs;
+    const uint16_t *_rhs;
+    const uint8_t *_predicts;
+  };
+
+  symtab _terms;
+  symtab _nonterms;
+
+  size_t _ruleCount = 0;
+  const uint16_t *_lhs = nullptr;
+  const uint32_t *_rhsOffs = nullptr;
+  const uint16_t *_rhs = nullptr;
+  const uint8_t *_predicts = nullptr;
+
+  std::vector<uint16_t> _ownLhs;
+  std::vector<uint32_t> _ownRhsOffs;
+  std::vector<uint16_t> _ownRhs;
+  std::vector<uint8_t> _ownPredicts;
+  std::unique_ptr<source> _image;
+
+  void load(const std::string &doc);
+  void map(const std::string &path);
+  void use(const tables &t);
 };
 }
 
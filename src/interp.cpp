@@ -0,0 +1,118 @@
+//
+//  interp.cpp
+//  tiny
+//
+//  Created by Иван Дмитриевский on 18/10/26.
+//  Copyright (c) 2026 Ivan Dmitrievsky. All rights reserved.
+//
+
+#include "interp.h"
+#include "format.h"
+
+#include <cstdlib>
+
+namespace tiny {
+interp::interp(const ast &tree) : _tree(tree), _scope(tree) {}
+
+void interp::run(fdwriter &out) {
+  if (_tree.root() == ast::nil) {
+    return;
+  }
+  _out = &out;
+  _vars = _scope.init();
+  exec(_tree[_tree.root()]._b);
+  _out = nullptr;
+}
+
+void interp::exec(ast::ref stmt) {
+  for (; stmt != ast::nil; stmt = _tree[stmt]._next) {
+    const ast::node &n = _tree[stmt];
+    switch (n._kind) {
+    case ast::kind::assign:
+      _vars[_scope[n._a]] = eval(n._b);
+      break;
+    case ast::kind::ifStmt:
+      exec(eval(n._a) ? n._b : n._c);
+      break;
+    case ast::kind::whileStmt:
+      while (eval(n._a)) {
+        exec(n._b);
+      }
+      break;
+    case ast::kind::print: {
+      // All values first, so a failing one leaves no partial line.
+      _values.clear();
+      for (ast::ref e = n._a; e != ast::nil; e = _tree[e]._next) {
+        _values.push_back(eval(e));
+      }
+      fmt::Writer &w = _out->out();
+      for (size_t i = 0; i < _values.size(); ++i) {
+        if (i > 0) {
+          w << ' ';
+        }
+        w << _values[i];
+      }
+      w << '\n';
+      _out->spill();
+      break;
+    }
+    default:
+      break;
+    }
+  }
+}
+
+int64_t interp::eval(ast::ref e) {
+  const ast::node &n = _tree[e];
+  switch (n._kind) {
+  case ast::kind::ident:
+    return _vars[_scope[e]];
+  case ast::kind::num:
+    return _tree.value(e);
+  case ast::kind::lor:
+    return eval(n._a) || eval(n._b);
+  case ast::kind::land:
+    return eval(n._a) && eval(n._b);
+  case ast::kind::lnot:
+    return !eval(n._a);
+  default:
+    break;
+  }
+
+  int64_t a = eval(n._a), b = eval(n._b);
+  switch (n._kind) {
+  case ast::kind::lt:
+    return a < b;
+  case ast::kind::le:
+    return a <= b;
+  case ast::kind::gt:
+    return a > b;
+  case ast::kind::ge:
+    return a >= b;
+  case ast::kind::eq:
+    return a == b;
+  case ast::kind::ne:
+    return a != b;
+  case ast::kind::add:
+    return int64_t(uint64_t(a) + uint64_t(b));
+  case ast::kind::sub:
+    return int64_t(uint64_t(a) - uint64_t(b));
+  case ast::kind::mul:
+    return int64_t(uint64_t(a) * uint64_t(b));
+  case ast::kind::div:
+    if (b == 0) {
+      fail("Division by zero");
+    }
+    // The one quotient that overflows wraps like the other operators.
+    return b == -1 ? int64_t(0 - uint64_t(a)) : a / b;
+  default:
+    return 0;
+  }
+}
+
+void interp::fail(const char *what) {
+  _out->flush();
+  fmt::printf("%s\n", what);
+  exit(EXIT_FAILURE);
+}
+}
@@ -0,0 +1,55 @@
+//
+//  interp.h
+//  tiny
+//
+//  Created by Иван Дмитриевский on 18/10/26.
+//  Copyright (c) 2026 Ivan Dmitrievsky. All rights reserved.
+//
+
+#ifndef __tiny__interp__
+#define __tiny__interp__
+
+#include "ast.h"
+#include "fdwriter.h"
+#include "scope.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace tiny {
+// Runs a program by walking its syntax tree. Variables are resolved to
+// slots before the first statement runs, so evaluation indexes an array
+// and never looks at a name.
+//
+// Values are 64-bit integers that wrap around. Comparisons, `!`, `&` and
+// `|` give 1 or 0 and treat any nonzero operand as true; `&` and `|` stop
+// at the first operand that decides the result. print evaluates all its
+// values, then writes them separated by spaces on one line.
+class interp {
+public:
+  // Exits when the program's variables do not resolve, see scope.
+  explicit interp(const ast &tree);
+
+  interp(const interp &) = delete;
+  interp &operator=(const interp &) = delete;
+
+  // Runs the program from the declared initial values. Division by zero
+  // is reported and exits.
+  void run(fdwriter &out);
+
+  size_t slots() const { return _scope.size(); }
+
+private:
+  const ast &_tree;
+  scope _scope;
+  std::vector<int64_t> _vars;
+  std::vector<int64_t> _values;
+  fdwriter *_out = nullptr;
+
+  void exec(ast::ref stmt);
+  int64_t eval(ast::ref e);
+  void fail(const char *what);
+};
+}
+
+#endif /* defined(__tiny__interp__) */
@@ -40,7 +40,12 @@ using std::move;
  * Serialization
  */
 
-static void dump(std::nullptr_t, string &out) { out += "null"; }
+struct NullStruct {
+  bool operator==(NullStruct) const { return true; }
+  bool operator<(NullStruct) const { return false; }
+};
+
+static void dump(NullStruct, string &out) { out += "null"; }
 
 static void dump(double value, string &out) {
   char buf[32];
@@ -209,9 +214,9 @@ public:
   explicit JsonObject(Json::object &&value) : Value(move(value)) {}
 };
 
-class JsonNull final : public Value<Json::NUL, std::nullptr_t> {
+class JsonNull final : public Value<Json::NUL, NullStruct> {
 public:
-  JsonNull() : Value(nullptr) {}
+  JsonNull() : Value({}) {}
 };
 
 /* * * * * * * * * * * * * * * * * * * *
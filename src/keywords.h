@@ -0,0 +1,74 @@
+//
+//  keywords.h
+//  tiny
+//
+//  Created by Иван Дмитриевский on 18/10/26.
+//  Copyright (c) 2026 Ivan Dmitrievsky. All rights reserved.
+//
+
+#ifndef __tiny__keywords__
+#define __tiny__keywords__
+
+#include "grammar_tables.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace tiny {
+// Word terminals of the built-in grammar behind a perfect hash on (first
+// char, length). tools/embed lists them from grammar.json, the slot table
+// is computed by the compiler, and a word that collides fails the build
+// instead of slowing down the lexer.
+namespace keywords {
+constexpr const char *const *all = builtin::keyWords;
+constexpr int count = builtin::keyWordCount;
+
+constexpr size_t length(const char *s) { return *s ? 1 + length(s + 1) : 0; }
+
+constexpr size_t slotCount = 16;
+constexpr size_t hash(char first, size_t len) {
+  return (static_cast<unsigned char>(first) + len) & (slotCount - 1);
+}
+
+constexpr int owner(size_t slot, int k = 0) {
+  return k == count ? -1
+                    : hash(all[k][0], length(all[k])) == slot
+                          ? k
+                          : owner(slot, k + 1);
+}
+
+constexpr bool perfect(int k = 0) {
+  return k == count ||
+         (owner(hash(all[k][0], length(all[k]))) == k && perfect(k + 1));
+}
+static_assert(perfect(), "keyword hash has collisions");
+
+constexpr int8_t slots[slotCount] = {
+    owner(0),  owner(1),  owner(2),  owner(3), owner(4),  owner(5),
+    owner(6),  owner(7),  owner(8),  owner(9), owner(10), owner(11),
+    owner(12), owner(13), owner(14), owner(15),
+};
+
+constexpr uint8_t slotLength(size_t slot) {
+  return owner(slot) < 0 ? 0 : length(all[owner(slot)]);
+}
+
+constexpr uint8_t lengths[slotCount] = {
+    slotLength(0),  slotLength(1),  slotLength(2),  slotLength(3),
+    slotLength(4),  slotLength(5),  slotLength(6),  slotLength(7),
+    slotLength(8),  slotLength(9),  slotLength(10), slotLength(11),
+    slotLength(12), slotLength(13), slotLength(14), slotLength(15),
+};
+
+// Index into all, or -1 when s is not a keyword.
+inline int find(const char *s, size_t len) {
+  size_t h = hash(s[0], len);
+  int k = slots[h];
+  return k >= 0 && lengths[h] == len && memcmp(all[k], s, len) == 0 ? k
+                                                                      : -1;
+}
+}
+}
+
+#endif /* defined(__tiny__keywords__) */
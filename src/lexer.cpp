@@ -8,36 +8,174 @@
 
 #include "format.h"
 #include "lexer.h"
+#include "scan.h"
 
-#include <set>
+#include <algorithm>
+#include <cstring>
 
 namespace tiny {
-std::list<token> lex::run(std::fstream &src) {
-  _itr = std::istreambuf_iterator<char>(src);
-  std::string ops("+-*/(<>)=,");
-  std::set<std::string> keyWords = {"begin", "end", "if", "while", "print"};
-  std::list<token> tokens;
+lex::lex(const grammar &gramm)
+    : _terms(gramm.terms()), _ident(gramm.mt("ident")._id),
+      _num(gramm.mt("num")._id) {
+  for (int k = 0; k < keywords::count; ++k) {
+    _keyWords[k] = _terms.find(keywords::all[k]);
+  }
+  for (symtab::id i = 0; i < _terms.size(); ++i) {
+    const char *name = _terms.name(i);
+    size_t len = strlen(name);
+    if (i != _ident && i != _num && (isAlpha(name[0]) || name[0] == '_') &&
+        scan::word(name + 1, name + len) == name + len &&
+        keywords::find(name, len) < 0) {
+      _extraWords = true;
+    }
+  }
+}
 
-  getChar();
-  while (_itr != _end) {
-    getWs();
-    if (isAlpha(_lookAhead) || _lookAhead == '_') {
-      tokens.push_back(getWord());
-      if (keyWords.find(tokens.back()._val) != keyWords.end()) {
-        tokens.back()._info._keyWord = true;
-      }
-    } else if (isDigit(_lookAhead)) {
-      tokens.push_back(getNum());
-    } else if (ops.find(_lookAhead) != std::string::npos) {
-      tokens.push_back(getOp());
-    } else {
-      fmt::printf("Unknown symbol %c at %ld:%ld\n", _lookAhead, _lineNum,
-                  _linePos);
-      exit(EXIT_FAILURE);
+struct lex::chunk {
+  size_t _begin;
+  size_t _end;
+  tokbuf _tokens;
+  const char *_bad = nullptr;
+};
+
+void lex::run(const source &src, tokbuf &out) {
+  out.clear();
+  out.reserve(src.size() / 6);
+  for (open(src); !done(); advance()) {
+    out.push(peek());
+  }
+}
+
+bool lex::run(const source &src, tokbuf &out, std::string &err) {
+  _quiet = true;
+  run(src, out);
+  _quiet = false;
+  if (_bad) {
+    err = message(_bad);
+    return false;
+  }
+  return true;
+}
+
+void lex::run(const source &src, tokbuf &out, pool &workers) {
+  const size_t minChunk = 1 << 20;
+  size_t n = std::min(workers.size() * 4, src.size() / minChunk + 1);
+  if (n < 2) {
+    run(src, out);
+    return;
+  }
+  check(src);
+
+  std::vector<chunk> chunks;
+  size_t begin = 0;
+  for (size_t i = 1; i <= n && begin < src.size(); ++i) {
+    size_t end = src.size();
+    if (i < n) {
+      size_t at = std::max(begin, src.size() / n * i);
+      auto nl = static_cast<const char *>(
+          memchr(src.data() + at, '\n', src.size() - at));
+      end = nl ? nl - src.data() + 1 : src.size();
     }
+    chunks.emplace_back();
+    chunks.back()._begin = begin;
+    chunks.back()._end = end;
+    begin = end;
+  }
+
+  workers.each(chunks.size(), [this, &src, &chunks](size_t i) {
+    chunk &c = chunks[i];
+    lex part(*this);
+    part._quiet = true;
+    c._tokens.reserve((c._end - c._begin) / 6);
+    for (part.open(src, c._begin, c._end); !part.done(); part.advance()) {
+      c._tokens.push(part.peek());
+    }
+    c._bad = part._bad;
+  });
+
+  size_t total = 0;
+  for (auto &c : chunks) {
+    total += c._tokens.size();
+  }
+  out.clear();
+  out.reserve(total);
+
+  for (auto &c : chunks) {
+    if (c._bad) {
+      _src = &src;
+      _base = src.data();
+      report(c._bad);
+    }
+    out.append(c._tokens);
+  }
+}
+
+void lex::open(const source &src) {
+  check(src);
+  open(src, 0, src.size());
+}
+
+void lex::check(const source &src) {
+  if (src.size() > UINT32_MAX) {
+    fmt::printf("Input of %d bytes is too large, tokens hold 32-bit offsets\n",
+                src.size());
+    exit(EXIT_FAILURE);
+  }
+}
+
+void lex::open(const source &src, size_t begin, size_t end) {
+  _src = &src;
+  _base = src.data();
+  _cur = _base + begin;
+  _end = _base + end;
+  _bad = nullptr;
+  load();
+  advance();
+}
+
+void lex::advance() {
+  static const char ops[] = "+-*/(<>)=,|&!";
+
+  getWs();
+  _done = _cur == _end;
+  if (_done) {
+    return;
+  }
+
+  if (isAlpha(_lookAhead) || _lookAhead == '_') {
+    _tok = getWord();
+  } else if (isDigit(_lookAhead)) {
+    _tok = getNum();
+  } else if (strchr(ops, _lookAhead) && _lookAhead != '\0') {
+    _tok = getOp();
+  } else {
+    fail(_cur);
   }
+}
 
-  return tokens;
+void lex::fail(const char *at) {
+  if (_quiet) {
+    _bad = at;
+    _done = true;
+  } else {
+    report(at);
+  }
+}
+
+void lex::report(const char *at) {
+  fmt::printf("%s", message(at));
+  exit(EXIT_FAILURE);
+}
+
+std::string lex::message(const char *at) const {
+  details pos = _src->where(at - _base);
+  if (isDigit(*at)) {
+    std::string num(at, scan::digits(at, _base + _src->size()));
+    return fmt::sprintf("Number %s at %ld:%ld does not fit in 64 bits\n", num,
+                        pos._lineNum, pos._linePos);
+  }
+  return fmt::sprintf("Unknown symbol %c at %ld:%ld\n", *at, pos._lineNum,
+                      pos._linePos);
 }
 
 bool lex::isAlpha(char c) {
@@ -46,69 +184,80 @@ bool lex::isAlpha(char c) {
 
 bool lex::isDigit(char c) { return '0' <= c && c <= '9'; }
 
-bool lex::isAlphaNum(char c) { return isAlpha(c) || isDigit(c); }
-
-bool lex::isWs(char c) { return c == ' ' || c == '\t' || c == '\n'; }
+void lex::load() { _lookAhead = _cur != _end ? *_cur : '\0'; }
 
 void lex::getChar() {
-  _lookAhead = *_itr;
-  ++_itr;
-  ++_linePos;
-  if (_lookAhead == '\n') {
-    ++_lineNum;
-    _linePos = 0;
-  }
+  ++_cur;
+  load();
 }
 
 void lex::getWs() {
-  while (isWs(_lookAhead)) {
-    getChar();
-  }
+  _cur = scan::ws(_cur, _end);
+  load();
 }
 
-token lex::getWord() {
+token lex::start(token::klass k) {
   token t;
-  t._info._linePos = _linePos;
-  t._info._lineNum = _lineNum;
-  t._klass = token::klass::word;
+  t._off = _cur - _base;
+  t._len = 0;
+  t._sym = symtab::none;
+  t._klass = k;
+  t._num = 0;
+  return t;
+}
 
-  std::string val;
-  do {
-    val.push_back(_lookAhead);
-    getChar();
-  } while (isAlphaNum(_lookAhead) || _lookAhead == '_');
+// Keywords the grammar does not use are plain identifiers.
+token lex::getWord() {
+  token t = start(token::klass::ident);
+  _cur = scan::word(_cur + 1, _end);
+  load();
 
-  t._val = val;
+  t._len = _cur - _base - t._off;
+  int k = keywords::find(_base + t._off, t._len);
+  symtab::id sym = k >= 0 ? _keyWords[k] : symtab::none;
+  if (sym == symtab::none && _extraWords) {
+    sym = _terms.find(_base + t._off, t._len);
+    if (sym == _ident || sym == _num) {
+      sym = symtab::none;
+    }
+  }
+  if (sym != symtab::none) {
+    t._klass = token::klass::keyWord;
+    t._sym = sym;
+  } else {
+    t._sym = _ident;
+  }
   return t;
 }
 
 token lex::getNum() {
-  token t;
-  t._info._linePos = _linePos;
-  t._info._lineNum = _lineNum;
-  t._klass = token::klass::num;
-
-  std::string val;
-  do {
-    val.push_back(_lookAhead);
-    getChar();
-  } while (isDigit(_lookAhead));
+  token t = start(token::klass::num);
+  _cur = scan::digits(_cur + 1, _end);
+  load();
 
-  t._val = val;
+  t._len = _cur - _base - t._off;
+  t._sym = _num;
+  if (!scan::decimal(_base + t._off, t._len, t._num)) {
+    fail(_base + t._off);
+  }
   return t;
 }
 
 token lex::getOp() {
-  token t;
-  t._info._linePos = _linePos;
-  t._info._lineNum = _lineNum;
-  t._klass = token::klass::op;
-
-  std::string val;
-  val.push_back(_lookAhead);
+  token t = start(token::klass::op);
   getChar();
 
-  t._val = val;
+  t._len = 1;
+  if (_lookAhead == '=') {
+    symtab::id two = _terms.find(_base + t._off, 2);
+    if (two != symtab::none) {
+      getChar();
+      t._len = 2;
+      t._sym = two;
+      return t;
+    }
+  }
+  t._sym = _terms.find(_base + t._off, t._len);
   return t;
 }
 }
@@ -9,34 +9,70 @@
 #ifndef __tiny__lexer__
 #define __tiny__lexer__
 
+#include "grammar.h"
+#include "keywords.h"
+#include "pool.h"
+#include "source.h"
+#include "tokbuf.h"
 #include "token.h"
 
-#include <iterator>
-#include <fstream>
-#include <list>
+#include <string>
 
 namespace tiny {
+// Pull-based token stream over a source with one token of lookahead:
+// open() lexes the first token, peek() returns it and advance() lexes the
+// next one, so the parser can start before the whole input is tokenized.
 class lex {
 public:
-  std::list<token> run(std::fstream &src);
+  explicit lex(const grammar &gramm);
+  void run(const source &src, tokbuf &out);
+  // Returns false with the message in err instead of exiting on a bad
+  // symbol, for callers that lex many inputs.
+  bool run(const source &src, tokbuf &out, std::string &err);
+  // Same tokens as run(src, out), lexed in chunks split at newlines.
+  void run(const source &src, tokbuf &out, pool &workers);
+
+  void open(const source &src);
+  bool done() const { return _done; }
+  const token &peek() const { return _tok; }
+  void advance();
+  const source &src() const { return *_src; }
 
 private:
-  std::istreambuf_iterator<char> _itr;
-  const std::istreambuf_iterator<char> _end;
-  char _lookAhead = EOF;
-  long _lineNum = 1;
-  long _linePos = 0;
+  const symtab &_terms;
+  symtab::id _ident;
+  symtab::id _num;
+  symtab::id _keyWords[keywords::count];
+  // The grammar has word terminals that are not in keywords::all, so a word
+  // that misses the hash is looked up in _terms too.
+  bool _extraWords = false;
+  const source *_src = nullptr;
+  token _tok;
+  bool _done = true;
+  const char *_base = nullptr;
+  const char *_cur = nullptr;
+  const char *_end = nullptr;
+  char _lookAhead = '\0';
+  bool _quiet = false;
+  const char *_bad = nullptr;
 
   static bool isAlpha(char c);
   static bool isDigit(char c);
-  static bool isAlphaNum(char c);
-  static bool isWs(char c);
 
+  struct chunk;
+
+  static void check(const source &src);
+  void open(const source &src, size_t begin, size_t end);
+  void fail(const char *at);
+  void report(const char *at);
+  std::string message(const char *at) const;
+  void load();
   void getChar();
   void getWs();
   token getWord();
   token getNum();
   token getOp();
+  token start(token::klass k);
 };
 }
 #endif /* defined(__tiny__lexer__) */
@@ -7,24 +7,375 @@
 //
 
 #include "format.h"
-#include <fstream>
 
+#include "ast.h"
+#include "bytecode.h"
+#include "fdwriter.h"
+#include "interp.h"
 #include "lexer.h"
 #include "parser.h"
+#include "pool.h"
+#include "source.h"
+#include "tracefile.h"
+#include "vm.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+struct options {
+  tiny::parser::engine _engine = tiny::parser::engine::table;
+  bool _tree = false;
+  tiny::parser::format _format = tiny::parser::format::text;
+  size_t _maxErrors = 0;
+  // Binary traces go here instead of the text ones, diagnostics to stderr.
+  tiny::tracewriter *_traces = nullptr;
+};
+
+// What one batch thread keeps between files.
+struct worker {
+  worker(const tiny::grammar &g, const options &opts)
+      : _lex(g), _parser(g, opts._engine) {
+    _parser.recover(opts._maxErrors);
+  }
+
+  tiny::lex _lex;
+  tiny::parser _parser;
+  tiny::tokbuf _tokens;
+  tiny::parser::trace _rules;
+  tiny::ast _tree;
+};
+
+bool check(const tiny::grammar &g, const options &opts, worker &w,
+           const std::string &path, fmt::Writer &out, std::string &record) {
+  bool opened;
+  tiny::source input(path, opened);
+  std::string err;
+  if (!opened) {
+    out << "Cannot open " << path << '\n';
+  } else if (!w._lex.run(input, w._tokens, err)) {
+    out << err;
+  }
+  if (!err.empty() || !opened) {
+    w._rules.clear();
+    if (opts._traces) {
+      opts._traces->encode(w._rules, false, record);
+    }
+    return false;
+  }
+
+  w._parser.log(&out);
+  bool parsed = w._parser.run(w._tokens, input, w._rules);
+  if (opts._tree) {
+    if (parsed) {
+      w._tree.build(g, w._rules, w._tokens, input);
+      w._tree.dump(out);
+    }
+  }
+  if (opts._traces) {
+    opts._traces->encode(w._rules, parsed, record);
+  } else if (!opts._tree) {
+    w._parser.vis(w._rules, out, opts._format);
+  }
+  return parsed;
+}
+
+// Checks every file on the pool. Each file's output is buffered and
+// written as soon as all files before it are done, so the output is the
+// same for any number of threads.
+bool batch(const tiny::grammar &g, const options &opts,
+           const std::vector<std::string> &paths, size_t jobs) {
+  tiny::pool workers(jobs);
+  std::vector<std::unique_ptr<worker>> state;
+  for (size_t i = 0; i < workers.size(); ++i) {
+    state.emplace_back(new worker(g, opts));
+  }
+
+  std::mutex mutex;
+  std::vector<std::string> outputs(paths.size());
+  std::vector<std::string> records(paths.size());
+  std::vector<bool> done(paths.size());
+  FILE *text = opts._traces ? stderr : stdout;
+  size_t next = 0;
+  bool ok = true;
+  workers.eachSlot(paths.size(), [&](size_t i, size_t slot) {
+    fmt::MemoryWriter out;
+    out << "==> " << paths[i] << " <==\n";
+    std::string record;
+    bool checked = check(g, opts, *state[slot], paths[i], out, record);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    ok = ok && checked;
+    outputs[i] = out.str();
+    records[i].swap(record);
+    done[i] = true;
+    for (; next < paths.size() && done[next]; ++next) {
+      fwrite(outputs[next].data(), 1, outputs[next].size(), text);
+      std::string().swap(outputs[next]);
+      if (opts._traces) {
+        opts._traces->put(records[next]);
+        std::string().swap(records[next]);
+      }
+    }
+  });
+  return ok;
+}
+
+void readList(const char *listPath, std::vector<std::string> &paths) {
+  tiny::source list(listPath);
+  const char *cur = list.data();
+  const char *end = cur + list.size();
+  while (cur != end) {
+    const char *eol = std::find(cur, end, '\n');
+    const char *last = eol;
+    if (last != cur && last[-1] == '\r') {
+      --last;
+    }
+    if (last != cur) {
+      paths.emplace_back(cur, last);
+    }
+    cur = eol == end ? end : eol + 1;
+  }
+}
+
+int openTrace(const char *path) {
+  if (strcmp(path, "-") == 0) {
+    return STDOUT_FILENO;
+  }
+  int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    fmt::printf("Cannot write %s\n", path);
+    exit(EXIT_FAILURE);
+  }
+  return fd;
+}
+
+void replay(const tiny::grammar &g, const options &opts, const char *path) {
+  tiny::source input(path);
+  tiny::tracereader traces(input, g);
+  tiny::parser p(g);
+  tiny::parser::trace rules;
+  bool parsed;
+  while (traces.next(rules, parsed)) {
+    p.vis(rules, opts._format);
+  }
+}
+
+bool has(const std::vector<std::string> &given, const char *option) {
+  return std::find(given.begin(), given.end(), option) != given.end();
+}
+
+// Exits on the first given option that `mode` has no use for.
+void only(const std::vector<std::string> &given,
+          std::initializer_list<const char *> taken, const char *mode) {
+  for (const std::string &option : given) {
+    if (std::find_if(taken.begin(), taken.end(), [&](const char *t) {
+          return option == t;
+        }) == taken.end()) {
+      fmt::printf("%s does not go with %s\n", option, mode);
+      exit(EXIT_FAILURE);
+    }
+  }
+}
+}
 
 int main(int argc, const char *argv[]) {
-  std::fstream input;
+  std::vector<std::string> paths;
+  bool listed = false;
+  const char *grammarPath = nullptr;
+  const char *compileTo = nullptr;
+  const char *tracePath = nullptr;
+  const char *replayPath = nullptr;
+  bool run = false;
+  bool walk = false;
+  bool listing = false;
+  size_t jobs = 0;
+  options opts;
+  std::vector<std::string> given;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg.size() > 1 && arg[0] == '-') {
+      given.push_back(arg);
+    }
+    if (arg == "-j" && i + 1 < argc) {
+      jobs = std::max(1, atoi(argv[++i]));
+    } else if (arg == "--max-errors" && i + 1 < argc) {
+      opts._maxErrors = std::max(0, atoi(argv[++i]));
+    } else if (arg == "--grammar" && i + 1 < argc) {
+      grammarPath = argv[++i];
+    } else if (arg == "--ast") {
+      opts._tree = true;
+    } else if (arg == "--run") {
+      run = true;
+    } else if (arg == "--interp" && i + 1 < argc) {
+      std::string name = argv[++i];
+      if (name == "tree") {
+        walk = true;
+      } else if (name == "vm") {
+        walk = false;
+      } else {
+        fmt::printf("Unknown interpreter %s, expected tree or vm\n", name);
+        exit(EXIT_FAILURE);
+      }
+    } else if (arg == "--bytecode") {
+      listing = true;
+    } else if (arg == "--trace" && i + 1 < argc) {
+      tracePath = argv[++i];
+    } else if (arg == "--replay" && i + 1 < argc) {
+      replayPath = argv[++i];
+    } else if (arg == "--engine" && i + 1 < argc) {
+      std::string name = argv[++i];
+      if (name == "table") {
+        opts._engine = tiny::parser::engine::table;
+      } else if (name == "climb") {
+        opts._engine = tiny::parser::engine::climb;
+      } else if (name == "descent") {
+        opts._engine = tiny::parser::engine::descent;
+      } else {
+        fmt::printf("Unknown engine %s, expected table, climb or descent\n",
+                    name);
+        exit(EXIT_FAILURE);
+      }
+    } else if (arg == "--format" && i + 1 < argc) {
+      std::string name = argv[++i];
+      if (name == "text") {
+        opts._format = tiny::parser::format::text;
+      } else if (name == "jsonl") {
+        opts._format = tiny::parser::format::jsonl;
+      } else if (name == "dot") {
+        opts._format = tiny::parser::format::dot;
+      } else {
+        fmt::printf("Unknown format %s, expected text, jsonl or dot\n", name);
+        exit(EXIT_FAILURE);
+      }
+    } else if (arg == "--compile-grammar" && i + 1 < argc) {
+      compileTo = argv[++i];
+    } else if (arg == "--files-from" && i + 1 < argc) {
+      readList(argv[++i], paths);
+      listed = true;
+    } else if (arg.size() > 1 && arg[0] == '-') {
+      fmt::printf("Unknown option %s, or it needs a value\n", arg);
+      exit(EXIT_FAILURE);
+    } else {
+      paths.push_back(argv[i]);
+    }
+  }
+
+  bool many = listed || paths.size() > 1;
+  if (compileTo || replayPath) {
+    const char *mode = compileTo ? "--compile-grammar" : "--replay";
+    if (!paths.empty() || listed) {
+      fmt::printf("%s takes no programs\n", mode);
+      exit(EXIT_FAILURE);
+    }
+    if (compileTo) {
+      only(given, {"--grammar", "--compile-grammar"}, mode);
+    } else {
+      only(given, {"--grammar", "--replay", "--format"}, mode);
+    }
+  }
+  if (has(given, "--interp") && !run) {
+    fmt::printf("--interp does not go without --run\n");
+    exit(EXIT_FAILURE);
+  }
+  // Only the rule trace listing has a format.
+  for (const char *other : {"--ast", "--trace", "--run", "--bytecode"}) {
+    if (has(given, "--format") && has(given, other)) {
+      fmt::printf("--format does not go with %s\n", other);
+      exit(EXIT_FAILURE);
+    }
+  }
+  // A runtime error ends the process, so programs are run one at a time.
+  if (many && (run || listing)) {
+    fmt::printf("--run and --bytecode take a single program\n");
+    exit(EXIT_FAILURE);
+  }
+
+  std::unique_ptr<tiny::grammar> gramm(grammarPath
+                                           ? new tiny::grammar(grammarPath)
+                                           : new tiny::grammar());
+  const tiny::grammar &g = *gramm;
+  if (compileTo) {
+    g.save(compileTo);
+    return 0;
+  }
+  if (replayPath) {
+    replay(g, opts, replayPath);
+    return 0;
+  }
 
-  if (argc > 1) {
-    input.open(argv[1]);
+  std::unique_ptr<tiny::tracewriter> traces;
+  if (tracePath) {
+    traces.reset(new tiny::tracewriter(openTrace(tracePath), g));
+    opts._traces = traces.get();
   }
 
-  tiny::lex l;
-  tiny::parser p("/Users/ivandmi/Documents/dev/tiny/tiny/grammar.json",
-                 "/Users/ivandmi/Documents/dev/tiny/tiny/table.json");
+  if (many) {
+    size_t threads = jobs ? jobs : std::thread::hardware_concurrency();
+    return batch(g, opts, paths, threads) ? 0 : EXIT_FAILURE;
+  }
+
+  std::unique_ptr<tiny::source> input(
+      paths.empty() ? new tiny::source() : new tiny::source(paths[0]));
+
+  tiny::lex l(g);
+  tiny::parser p(g, opts._engine);
+  p.recover(opts._maxErrors);
+  fmt::MemoryWriter diag;
+  if (traces) {
+    p.log(&diag);
+  }
 
-  auto lst = p.run(l.run(input));
-  p.vis(lst);
+  tiny::parser::trace rules;
+  bool parsed;
+  if (jobs > 0 || opts._tree || run || listing || opts._maxErrors > 0) {
+    tiny::tokbuf tokens;
+    if (jobs > 0) {
+      tiny::pool workers(jobs);
+      l.run(*input, tokens, workers);
+    } else {
+      l.run(*input, tokens);
+    }
+    parsed = p.run(tokens, *input, rules);
+    if (opts._tree && parsed) {
+      tiny::ast t;
+      t.build(g, rules, tokens, *input);
+      t.dump();
+    }
+    if ((run || listing) && parsed) {
+      tiny::ast t;
+      t.build(g, rules, tokens, *input);
+      tiny::fdwriter out(STDOUT_FILENO);
+      if (listing) {
+        tiny::bytecode(t, tiny::scope(t)).dump(out.out());
+      } else if (walk) {
+        tiny::interp(t).run(out);
+      } else {
+        tiny::bytecode code(t, tiny::scope(t));
+        tiny::vm(code).run(out);
+      }
+    }
+  } else {
+    l.open(*input);
+    parsed = p.run(l, rules);
+  }
 
-  return 0;
+  if (traces) {
+    traces->put(rules, parsed);
+    fwrite(diag.data(), 1, diag.size(), stderr);
+  } else if (!opts._tree && !run && !listing) {
+    p.vis(rules, opts._format);
+  }
+  return (opts._tree || run || listing) && !parsed ? EXIT_FAILURE : 0;
 }
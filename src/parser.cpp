@@ -7,114 +7,344 @@
 //
 
 #include "parser.h"
+#include "fdwriter.h"
 #include "format.h"
-#include <stack>
+
+#include <algorithm>
+#include <cstdio>
+#include <utility>
+
+#include <unistd.h>
 
 namespace tiny {
-parser::parser(std::string grammarPath, std::string tablePath)
-    : _gramm(grammarPath, tablePath) {}
-
-std::list<size_t> parser::run(std::list<token> tokens) {
-  std::stack<grammar::lexem> s;
-  std::list<size_t> ruleNums;
-
-  s.push(grammar::mnt("program"));
-  auto token = tokens.begin();
-
-  while (!s.empty() && token != tokens.end()) {
-    auto top = s.top();
-
-    if (!top._term) {
-      bool found = false;
-      size_t ruleNum = _gramm.predict(top._val, *token, found);
-      if (found) {
-        ruleNums.push_back(ruleNum);
-        s.pop();
-        auto action = _gramm.rule(ruleNum).second;
-        for (auto it = action.rbegin(); it != action.rend(); ++it) {
-          if (!it->_val.empty()) {
-            s.push(*it);
-          }
+parser::parser(const grammar &gramm, engine e)
+    : _gramm(gramm), _start(gramm.lhs(0)._id), _engine(e),
+      _expand(gramm, e == engine::climb ? gramm.mnt("bool-exp")._id
+                                        : symtab::none) {
+  // The generated functions only know the built-in grammar; any other
+  // one is parsed by the table loop.
+  if (_engine == engine::descent && !_generatedFor(gramm)) {
+    _engine = engine::table;
+  }
+  if (_engine == engine::climb && !_setupClimb()) {
+    fmt::printf("The climb engine needs the TINY expression grammar\n");
+    exit(EXIT_FAILURE);
+  }
+  _stack.reserve(256);
+}
+
+bool parser::run(const tokbuf &tokens, const source &src, trace &out) {
+  _errors.clear();
+  _errorAt = SIZE_MAX;
+  tokbuf::cursor cursor(tokens, src);
+  bool ok = _engine == engine::descent
+                ? _descend(cursor, out)
+                : _run(cursor, out, _engine == engine::climb);
+  if (!ok && _limit && _engine != engine::table) {
+    _errors.clear();
+    _errorAt = SIZE_MAX;
+    tokbuf::cursor again(tokens, src);
+    ok = _run(again, out, false);
+  }
+  return _finish(ok);
+}
+
+// Errors are held until the rest of the input is lexed, so an unknown
+// symbol after them is reported instead, as when the tokens are buffered.
+bool parser::run(lex &tokens, trace &out) {
+  _errors.clear();
+  _errorAt = SIZE_MAX;
+  _hold = true;
+  bool ok = _engine == engine::descent
+                ? _descend(tokens, out)
+                : _run(tokens, out, _engine == engine::climb);
+  for (; !tokens.done(); tokens.advance()) {
+  }
+  return _finish(ok);
+}
+
+bool parser::_finish(bool ok) {
+  if (_limit || _hold) {
+    for (auto &err : _errors) {
+      _write(err);
+    }
+  }
+  _hold = false;
+  return ok;
+}
+
+template <class Tokens>
+bool parser::_run(Tokens &tokens, trace &out, bool climbing) {
+  out.clear();
+  _stack.clear();
+  _stack.push_back(_start);
+  const token *token = tokens.done() ? nullptr : &tokens.peek();
+  symtab::id sym = token ? token->_sym : symtab::none;
+
+  while (!_stack.empty() && token) {
+    grammar::lexem top = grammar::decode(_stack.back());
+
+    if (!top._term && climbing && top._id == _climb._nt[climb::boolExp]) {
+      _stack.pop_back();
+      if (!_expr(tokens, token, sym, out) && !_resync(tokens, token, sym)) {
+        return false;
+      }
+    } else if (!top._term) {
+      const expansions::cell &c = _expand.at(top._id, sym);
+      if (c._ruleCount) {
+        _stack.pop_back();
+        const uint8_t *rules = _expand.rules(c);
+        out.insert(out.end(), rules, rules + c._ruleCount);
+        const uint16_t *push = _expand.push(c);
+        _stack.insert(_stack.end(), push, push + c._pushCount);
+        if (c._match) {
+          tokens.advance();
+          token = tokens.done() ? nullptr : &tokens.peek();
+          sym = token ? token->_sym : symtab::none;
         }
       } else {
-        if (token->isw() && !token->_info._keyWord && token->_val != "ident") {
-          token->_val = "ident";
-          continue;
-        }
-        if (token->isn() && token->_val != "num") {
-          token->_val = "num";
-          continue;
+        _gerror(top, *token, tokens.src());
+        if (!_resync(tokens, token, sym)) {
+          return false;
         }
-        _gerror(top, *token);
-        return ruleNums;
       }
-    } else if (token->_val == top._val) {
-      s.pop();
-      ++token;
-    } else if (token->isn() && top._val == "num") {
-      s.pop();
-      ++token;
+    } else if (sym == top._id) {
+      _stack.pop_back();
+      tokens.advance();
+      token = tokens.done() ? nullptr : &tokens.peek();
+      sym = token ? token->_sym : symtab::none;
     } else {
-      _serror(top, *token);
-      return ruleNums;
+      _serror(top, token->val(tokens.src()),
+              tokens.src().where(token->_off));
+      if (!_resync(tokens, token, sym)) {
+        return false;
+      }
     }
   }
 
-  if (!s.empty()) {
-    _eoferror(s.top());
+  if (!_stack.empty()) {
+    _eoferror(grammar::decode(_stack.back()));
+    return false;
+  }
+  return _errors.empty();
+}
+
+// Panic mode: skips tokens up to one that a symbol pending on the stack can
+// go on with, which is the FOLLOW of the failed symbol in this context and
+// so takes in the statement keywords, then pops the stack down to it. A
+// second error on the same token is a cascade of the first one: it is
+// dropped and the token skipped, so every resync moves the input on.
+template <class Tokens>
+bool parser::_resync(Tokens &tokens, const token *&tok, symtab::id &sym) {
+  if (!_limit || !tok) {
+    return false;
+  }
+  auto next = [&tokens, &tok]() {
+    tokens.advance();
+    tok = tokens.done() ? nullptr : &tokens.peek();
+  };
+  if (tok->_off == _errorAt) {
+    _errors.pop_back();
+    next();
+  } else {
+    _errorAt = tok->_off;
+  }
+  if (_errors.size() >= _limit) {
+    return false;
   }
 
-  return ruleNums;
+  for (; tok; next()) {
+    for (size_t k = _stack.size(); k-- > 0;) {
+      if (_accepts(_stack[k], *tok)) {
+        _stack.resize(k + 1);
+        sym = tok->_sym;
+        return true;
+      }
+    }
+  }
+  sym = symtab::none;
+  return true;
+}
+
+bool parser::_accepts(uint16_t entry, const token &tok) const {
+  grammar::lexem l = grammar::decode(entry);
+  if (l._term) {
+    return l._id == tok._sym;
+  }
+  bool found = false;
+  _gramm.predict(l._id, tok._sym, found);
+  return found;
+}
+
+void parser::vis(const trace &rules, format f) const {
+  fflush(stdout);
+  vis(rules, STDOUT_FILENO, f);
 }
 
-void parser::vis(std::list<size_t> lst) {
-  for (auto num : lst) {
-    auto rule = _gramm.rule(num);
-    fmt::printf("<%s> -> ", rule.first._val);
-    auto rem = rule.second;
+void parser::vis(const trace &rules, int fd, format f) const {
+  fdwriter w(fd);
+  _vis(rules, w.out(), f, [&w]() { w.spill(); });
+}
+
+void parser::vis(const trace &rules, fmt::Writer &out, format f) const {
+  _vis(rules, out, f, []() {});
+}
 
-    if (rem[0]._term && !rem[0]._val.empty()) {
-      fmt::printf("%s", rem[0]._val);
+namespace {
+// Escapes what JSON and DOT strings cannot hold as is.
+void quoted(fmt::Writer &out, const char *s) {
+  out << '"';
+  for (; *s; ++s) {
+    if (*s == '"' || *s == '\\') {
+      out << '\\' << *s;
+    } else if (static_cast<unsigned char>(*s) < 0x20) {
+      out.write("\\u{:04x}", unsigned(*s));
     } else {
-      fmt::printf("<%s>", rem[0]._val);
+      out << *s;
     }
+  }
+  out << '"';
+}
+}
+
+template <class Spill>
+void parser::_vis(const trace &rules, fmt::Writer &out, format f,
+                  Spill spill) const {
+  // For the tree: nodes of nonterminals whose rule comes later, leftmost
+  // on top. Rules that do not continue the derivation, as after error
+  // recovery, start a new root.
+  std::vector<std::pair<size_t, symtab::id>> open;
+  size_t nodes = 0;
+  if (f == format::dot) {
+    out << "digraph parse {\n";
+  }
 
-    for (auto it = ++rem.begin(); it != rem.end(); ++it) {
-      if (it->_term && !it->_val.empty()) {
-        fmt::printf(", %s", it->_val);
+  for (auto num : rules) {
+    grammar::lexem lhs = _gramm.lhs(num);
+    grammar::span rem = _gramm.rhs(num);
+    switch (f) {
+    case format::text:
+      out << '<' << _gramm.name(lhs) << "> -> ";
+      if (rem.empty()) {
+        out << "<>";
+      }
+      for (size_t i = 0; i < rem.size(); ++i) {
+        if (i) {
+          out << ", ";
+        }
+        if (rem[i]._term) {
+          out << _gramm.name(rem[i]);
+        } else {
+          out << '<' << _gramm.name(rem[i]) << '>';
+        }
+      }
+      out << '\n';
+      break;
+
+    case format::jsonl:
+      out << "{\"rule\":" << unsigned(num) << ",\"lhs\":";
+      quoted(out, _gramm.name(lhs));
+      out << ",\"rhs\":[";
+      for (size_t i = 0; i < rem.size(); ++i) {
+        out << (i ? ",{" : "{") << (rem[i]._term ? "\"t\":" : "\"nt\":");
+        quoted(out, _gramm.name(rem[i]));
+        out << '}';
+      }
+      out << "]}\n";
+      break;
+
+    case format::dot: {
+      while (!open.empty() && open.back().second != lhs._id) {
+        open.pop_back();
+      }
+      size_t parent;
+      if (open.empty()) {
+        parent = nodes++;
+        out << "  n" << parent << " [label=";
+        quoted(out, _gramm.name(lhs));
+        out << "];\n";
       } else {
-        fmt::printf(", <%s>", it->_val);
+        parent = open.back().first;
+        open.pop_back();
+      }
+      if (rem.empty()) {
+        out << "  n" << nodes << " [label=\"\", shape=point];\n"
+            << "  n" << parent << " -> n" << nodes << ";\n";
+        ++nodes;
       }
+      size_t first = nodes;
+      for (size_t i = 0; i < rem.size(); ++i, ++nodes) {
+        out << "  n" << nodes << " [label=";
+        quoted(out, _gramm.name(rem[i]));
+        out << (rem[i]._term ? ", shape=box];\n" : "];\n") << "  n" << parent
+            << " -> n" << nodes << ";\n";
+      }
+      for (size_t i = rem.size(); i-- > 0;) {
+        if (!rem[i]._term) {
+          open.emplace_back(first + i, rem[i]._id);
+        }
+      }
+      break;
     }
-    fmt::printf("\n");
+    }
+    spill();
   }
-}
 
-void parser::_gerror(grammar::lexem l, token t) {
-  auto expected = _gramm.expected(l._val);
-  std::string err =
-      fmt::sprintf("Unexpected word %s at %ld:%ld. Expected %s", t._val,
-                   t._info._lineNum, t._info._linePos, expected[0]);
-  for (auto it = expected.begin() + 1; it != expected.end(); ++it) {
-    err += ", " + *it;
+  if (f == format::dot) {
+    out << "}\n";
   }
-  err += ".\n";
-  fmt::printf("%s", err);
+}
+
+void parser::_gerror(grammar::lexem l, const token &t,
+                     const source &src) {
+  // An operator the grammar has no terminal for is only known by spelling.
+  std::string word = t._sym == symtab::none ? t.val(src)
+                                            : _gramm.terms().name(t._sym);
+  details pos = src.where(t._off);
+  _error(fmt::sprintf("Unexpected word %s at %ld:%ld. Expected %s.\n", word,
+                      pos._lineNum, pos._linePos, _expected(l)));
 }
 
 void parser::_eoferror(grammar::lexem l) {
-  auto expected = _gramm.expected(l._val);
-  std::string err =
-      fmt::sprintf("Unexpected end of file. Expected %s", expected[0]);
-  for (auto it = expected.begin() + 1; it != expected.end(); ++it) {
-    err += ", " + *it;
+  _error(
+      fmt::sprintf("Unexpected end of file. Expected %s.\n", _expected(l)));
+}
+
+// A terminal is expected as itself, a nonterminal by what predicts it.
+std::string parser::_expected(grammar::lexem l) const {
+  if (l._term) {
+    return _gramm.terms().name(l._id);
+  }
+  auto expected = _gramm.expected(l._id);
+  std::string list;
+  for (auto it = expected.begin(); it != expected.end(); ++it) {
+    list += (it == expected.begin() ? "" : ", ") + *it;
+  }
+  return list;
+}
+
+void parser::_serror(grammar::lexem l, std::string val, details pos) {
+  _error(fmt::sprintf("Unexpected word %s at %ld:%ld. Expected %s.\n", val,
+                     pos._lineNum, pos._linePos, _gramm.name(l)));
+}
+
+// Errors stay in _errors; without recover() the only one is written right
+// away, otherwise they are written when the run ends.
+void parser::_error(const std::string &err) {
+  if (_errors.size() >= std::max<size_t>(_limit, 1)) {
+    return;
+  }
+  _errors.push_back(err);
+  if (!_limit && !_hold) {
+    _write(err);
   }
-  err += ".\n";
-  fmt::printf("%s", err);
 }
 
-void parser::_serror(grammar::lexem l, token t) {
-  fmt::printf("Unexpected word %s at %ld:%ld. Expected %s.\n", t._val,
-              t._info._lineNum, t._info._linePos, l._val);
+void parser::_write(const std::string &err) {
+  if (_log) {
+    *_log << err;
+  } else {
+    fmt::printf("%s", err);
+  }
 }
 }
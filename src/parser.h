@@ -9,23 +9,119 @@
 #ifndef __tiny__parser__
 #define __tiny__parser__
 
-#include <list>
+#include <cstdint>
 #include <string>
+#include <vector>
+#include "expansions.h"
+#include "format.h"
+#include "source.h"
 #include "token.h"
 #include "grammar.h"
+#include "lexer.h"
+#include "tokbuf.h"
 
 namespace tiny {
+// Three engines produce the same rule trace: the table-driven loop, which
+// applies the rules between two input symbols in one step (see expansions),
+// the same loop handing every bool-exp to a precedence-climbing expression
+// parser, and the recursive-descent parser generated from the built-in
+// grammar at build time. Asked for descent with any other grammar, the
+// parser runs the table loop. The climbing engine can leave expression
+// rules out of the trace when only the statement structure is wanted.
+//
+// The trace is one byte per applied rule (grammars have fewer than 255)
+// and is filled into the caller's buffer, the symbol stack is kept between
+// runs, so a warmed-up parser does not allocate per token. run() reports
+// the first error and returns false, the trace then stops there. Errors go
+// to stdout unless log() points them at a writer.
+//
+// With recover() the table loop goes on after an error in panic mode and
+// the run collects up to limit errors, written out when it ends. The
+// climbing and descent engines hand a failed token buffer over to the
+// table loop from the start, so all engines report the same errors; a
+// streamed descent run still stops at the first one.
 class parser {
 public:
-  parser(std::string grammarPath, std::string tablePath);
-  std::list<size_t> run(std::list<token>);
-  void vis(std::list<size_t>);
+  enum class engine { table, climb, descent };
+  typedef std::vector<uint8_t> trace;
+
+  explicit parser(const grammar &gramm, engine e = engine::table);
+  bool run(const tokbuf &tokens, const source &src, trace &out);
+  bool run(lex &tokens, trace &out);
+  // How vis() shows a trace: a rule per line, a JSON object per line, or
+  // the parse tree as a Graphviz digraph.
+  enum class format { text, jsonl, dot };
+  void vis(const trace &rules, format f = format::text) const;
+  void vis(const trace &rules, int fd, format f = format::text) const;
+  void vis(const trace &rules, fmt::Writer &out,
+           format f = format::text) const;
+  void log(fmt::Writer *out) { _log = out; }
+  void recover(size_t limit) { _limit = limit; }
+  const std::vector<std::string> &errors() const { return _errors; }
+
+  void exprTrace(bool on) { _exprTrace = on; }
 
 private:
-  grammar _gramm;
-  void _gerror(grammar::lexem l, token t);
+  const grammar &_gramm;
+  symtab::id _start;
+  engine _engine;
+  expansions _expand;
+  std::vector<uint16_t> _stack;
+
+  // The expression grammar as a chain of steps from bool-exp down to
+  // factor. Binary steps have a tail nonterminal whose non-empty rule is
+  // `op operand tail`, operands start again at _operand.
+  struct climb {
+    enum step { boolExp, boolTerm, notFactor, relation, exp, term, factor };
+    static const size_t steps = factor + 1;
+    symtab::id _nt[steps];
+    symtab::id _tail[steps];
+    step _operand[steps];
+    symtab::id _notOpt;
+    // Rules applied from each step down to factor for a token that starts
+    // a plain operand, and which terminals do.
+    std::vector<uint8_t> _chain[steps];
+    std::vector<bool> _plain;
+    // What a terminal does after an operand with every tail pending: the
+    // step whose operator it is, closes (all tails end) or slow (a tail
+    // has no prediction for it, the error comes from the slow path).
+    enum : int8_t { closes = -1, slow = -2 };
+    std::vector<int8_t> _opStep;
+    std::vector<uint8_t> _opRule;
+    uint8_t _end[steps];
+    uint8_t _more[steps];
+  };
+  climb _climb;
+  bool _exprTrace = true;
+  fmt::Writer *_log = nullptr;
+  size_t _limit = 0;
+  bool _hold = false;
+  std::vector<std::string> _errors;
+  size_t _errorAt = SIZE_MAX;
+  template <class Tokens> class climber;
+  bool _setupClimb();
+  template <class Tokens>
+  bool _expr(Tokens &tokens, const token *&tok, symtab::id &sym, trace &out);
+
+  template <class Tokens> class driver;
+  static bool _generatedFor(const grammar &gramm);
+  template <class Tokens>
+  bool _run(Tokens &tokens, trace &out, bool climbing);
+  template <class Tokens>
+  bool _resync(Tokens &tokens, const token *&tok, symtab::id &sym);
+  bool _accepts(uint16_t entry, const token &tok) const;
+  bool _finish(bool ok);
+  template <class Tokens> bool _descend(Tokens &tokens, trace &out);
+  void _gerror(grammar::lexem l, const token &t, const source &src);
   void _eoferror(grammar::lexem l);
-  void _serror(grammar::lexem l, token t);
+  std::string _expected(grammar::lexem l) const;
+  void _serror(grammar::lexem l, std::string val, details pos);
+  template <class Spill>
+  void _vis(const trace &rules, fmt::Writer &out, format f,
+            Spill spill) const;
+  void _visJson(size_t num, fmt::Writer &out) const;
+  void _error(const std::string &err);
+  void _write(const std::string &err);
 };
 }
 
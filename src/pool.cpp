@@ -0,0 +1,117 @@
+//
+//  pool.cpp
+//  tiny
+//
+//  Created by Иван Дмитриевский on 18/10/26.
+//  Copyright (c) 2026 Ivan Dmitrievsky. All rights reserved.
+//
+
+#include "pool.h"
+
+#include <algorithm>
+
+namespace tiny {
+pool::pool(size_t threads)
+    : _ranges(new range[std::max<size_t>(threads, 1)]) {
+  for (size_t i = 1; i < threads; ++i) {
+    _threads.emplace_back(&pool::work, this, i);
+  }
+}
+
+pool::~pool() {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stop = true;
+  }
+  _wake.notify_all();
+  for (auto &t : _threads) {
+    t.join();
+  }
+}
+
+void pool::each(size_t n, const std::function<void(size_t)> &fn) {
+  eachSlot(n, [&fn](size_t i, size_t) { fn(i); });
+}
+
+void pool::eachSlot(size_t n,
+                    const std::function<void(size_t, size_t)> &fn) {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _fn = &fn;
+    for (size_t i = 0; i < size(); ++i) {
+      _ranges[i]._begin = n * i / size();
+      _ranges[i]._end = n * (i + 1) / size();
+    }
+    _busy = _threads.size();
+    ++_round;
+  }
+  _wake.notify_all();
+  drain(0);
+
+  std::unique_lock<std::mutex> lock(_mutex);
+  _idle.wait(lock, [this]() { return _busy == 0; });
+}
+
+void pool::work(size_t self) {
+  uint64_t seen = 0;
+  std::unique_lock<std::mutex> lock(_mutex);
+  for (;;) {
+    _wake.wait(lock, [this, &seen]() { return _stop || _round != seen; });
+    if (_stop) {
+      return;
+    }
+    seen = _round;
+
+    lock.unlock();
+    drain(self);
+    lock.lock();
+    if (--_busy == 0) {
+      _idle.notify_all();
+    }
+  }
+}
+
+void pool::drain(size_t self) {
+  size_t i;
+  while (pop(self, i) || steal(self, i)) {
+    (*_fn)(i, self);
+  }
+}
+
+bool pool::pop(size_t self, size_t &i) {
+  range &own = _ranges[self];
+  std::lock_guard<std::mutex> lock(own._mutex);
+  if (own._begin == own._end) {
+    return false;
+  }
+  i = own._begin++;
+  return true;
+}
+
+// Only called with an empty own range, nobody else adds to it, so the
+// victim's lock is never held together with ours.
+bool pool::steal(size_t self, size_t &i) {
+  for (size_t k = 1; k < size(); ++k) {
+    range &victim = _ranges[(self + k) % size()];
+    size_t begin, end;
+    {
+      std::lock_guard<std::mutex> lock(victim._mutex);
+      size_t left = victim._end - victim._begin;
+      if (left == 0) {
+        continue;
+      }
+      end = victim._end;
+      begin = end - (left + 1) / 2;
+      victim._end = begin;
+    }
+
+    range &own = _ranges[self];
+    std::lock_guard<std::mutex> lock(own._mutex);
+    i = begin;
+    own._begin = begin + 1;
+    own._end = end;
+    return true;
+  }
+  return false;
+}
+}
@@ -0,0 +1,64 @@
+//
+//  pool.h
+//  tiny
+//
+//  Created by Иван Дмитриевский on 18/10/26.
+//  Copyright (c) 2026 Ivan Dmitrievsky. All rights reserved.
+//
+
+#ifndef __tiny__pool__
+#define __tiny__pool__
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace tiny {
+// Fixed set of worker threads. each() runs fn(0) .. fn(n - 1) across the
+// workers and the calling thread, and returns once all of them finished.
+// Every thread starts on its own slice of the indices and, once that runs
+// dry, steals the back half of someone else's, so a few slow items do not
+// leave the rest of the threads idle.
+class pool {
+public:
+  explicit pool(size_t threads = std::thread::hardware_concurrency());
+  ~pool();
+
+  pool(const pool &) = delete;
+  pool &operator=(const pool &) = delete;
+
+  size_t size() const { return _threads.size() + 1; }
+  void each(size_t n, const std::function<void(size_t)> &fn);
+  // Same, also passing which thread runs the item, 0 .. size() - 1, so
+  // callers can keep per-thread state in an array of size().
+  void eachSlot(size_t n, const std::function<void(size_t, size_t)> &fn);
+
+private:
+  struct range {
+    std::mutex _mutex;
+    size_t _begin = 0;
+    size_t _end = 0;
+  };
+
+  std::vector<std::thread> _threads;
+  std::unique_ptr<range[]> _ranges;
+  std::mutex _mutex;
+  std::condition_variable _wake;
+  std::condition_variable _idle;
+  const std::function<void(size_t, size_t)> *_fn = nullptr;
+  size_t _busy = 0;
+  uint64_t _round = 0;
+  bool _stop = false;
+
+  void work(size_t self);
+  void drain(size_t self);
+  bool pop(size_t self, size_t &i);
+  bool steal(size_t self, size_t &i);
+};
+}
+
+#endif /* defined(__tiny__pool__) */
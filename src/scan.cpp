@@ -0,0 +1,270 @@
+//
+//  scan.cpp
+//  tiny
+//
+//  Created by Иван Дмитриевский on 18/10/26.
+//  Copyright (c) 2026 Ivan Dmitrievsky. All rights reserved.
+//
+
+#include "scan.h"
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define TINY_SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+namespace tiny {
+namespace scan {
+namespace {
+bool isWs(char c) { return c == ' ' || c == '\t' || c == '\n'; }
+
+bool isDigit(char c) { return '0' <= c && c <= '9'; }
+
+bool isWord(char c) {
+  return ('a' <= c && c <= 'z') || ('A' <= c && c <= 'Z') || isDigit(c) ||
+         c == '_';
+}
+
+const char *wsScalar(const char *p, const char *end) {
+  while (p != end && isWs(*p)) {
+    ++p;
+  }
+  return p;
+}
+
+const char *wordScalar(const char *p, const char *end) {
+  while (p != end && isWord(*p)) {
+    ++p;
+  }
+  return p;
+}
+
+const char *digitsScalar(const char *p, const char *end) {
+  while (p != end && isDigit(*p)) {
+    ++p;
+  }
+  return p;
+}
+
+#ifdef TINY_SCAN_X86
+__m128i inRange(__m128i v, char lo, char hi) {
+  return _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(lo - 1)),
+                       _mm_cmplt_epi8(v, _mm_set1_epi8(hi + 1)));
+}
+
+const char *wsSse2(const char *p, const char *end) {
+  for (; end - p >= 16; p += 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    __m128i ws = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')),
+                     _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))),
+        _mm_cmpeq_epi8(v, _mm_set1_epi8('\n')));
+    uint32_t stop = ~_mm_movemask_epi8(ws) & 0xffff;
+    if (stop) {
+      return p + __builtin_ctz(stop);
+    }
+  }
+  return wsScalar(p, end);
+}
+
+const char *wordSse2(const char *p, const char *end) {
+  for (; end - p >= 16; p += 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    __m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+    __m128i word = _mm_or_si128(
+        _mm_or_si128(inRange(lower, 'a', 'z'), inRange(v, '0', '9')),
+        _mm_cmpeq_epi8(v, _mm_set1_epi8('_')));
+    uint32_t stop = ~_mm_movemask_epi8(word) & 0xffff;
+    if (stop) {
+      return p + __builtin_ctz(stop);
+    }
+  }
+  return wordScalar(p, end);
+}
+
+const char *digitsSse2(const char *p, const char *end) {
+  for (; end - p >= 16; p += 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    uint32_t stop = ~_mm_movemask_epi8(inRange(v, '0', '9')) & 0xffff;
+    if (stop) {
+      return p + __builtin_ctz(stop);
+    }
+  }
+  return digitsScalar(p, end);
+}
+
+__attribute__((target("avx2"))) __m256i inRange256(__m256i v, char lo,
+                                                   char hi) {
+  return _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8(lo - 1)),
+                          _mm256_cmpgt_epi8(_mm256_set1_epi8(hi + 1), v));
+}
+
+__attribute__((target("avx2"))) const char *wsAvx2(const char *p,
+                                                   const char *end) {
+  for (; end - p >= 32; p += 32) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+    __m256i ws = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')),
+                        _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t'))),
+        _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')));
+    uint32_t stop = ~static_cast<uint32_t>(_mm256_movemask_epi8(ws));
+    if (stop) {
+      return p + __builtin_ctz(stop);
+    }
+  }
+  return wsSse2(p, end);
+}
+
+__attribute__((target("avx2"))) const char *wordAvx2(const char *p,
+                                                     const char *end) {
+  for (; end - p >= 32; p += 32) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+    __m256i lower = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+    __m256i word = _mm256_or_si256(
+        _mm256_or_si256(inRange256(lower, 'a', 'z'), inRange256(v, '0', '9')),
+        _mm256_cmpeq_epi8(v, _mm256_set1_epi8('_')));
+    uint32_t stop = ~static_cast<uint32_t>(_mm256_movemask_epi8(word));
+    if (stop) {
+      return p + __builtin_ctz(stop);
+    }
+  }
+  return wordSse2(p, end);
+}
+
+__attribute__((target("avx2"))) const char *digitsAvx2(const char *p,
+                                                       const char *end) {
+  for (; end - p >= 32; p += 32) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+    uint32_t stop =
+        ~static_cast<uint32_t>(_mm256_movemask_epi8(inRange256(v, '0', '9')));
+    if (stop) {
+      return p + __builtin_ctz(stop);
+    }
+  }
+  return digitsSse2(p, end);
+}
+#endif
+
+// Eight ASCII digits to their value in three multiplies: adjacent digits,
+// then pairs, then quads are merged within the word. Expects the first
+// digit in the lowest byte.
+uint64_t swar8(const char *p) {
+  uint64_t v;
+  memcpy(&v, p, sizeof(v));
+  v -= 0x3030303030303030ull;
+  v = (v * 10 + (v >> 8)) & 0x00ff00ff00ff00ffull;
+  v = (v * (1 + (100ull << 16)) >> 16) & 0x0000ffff0000ffffull;
+  return v * (1 + (10000ull << 32)) >> 32;
+}
+
+struct impl {
+  isa _isa;
+  const char *(*_ws)(const char *, const char *);
+  const char *(*_word)(const char *, const char *);
+  const char *(*_digits)(const char *, const char *);
+};
+
+const impl impls[] = {
+    {isa::scalar, wsScalar, wordScalar, digitsScalar},
+#ifdef TINY_SCAN_X86
+    {isa::sse2, wsSse2, wordSse2, digitsSse2},
+    {isa::avx2, wsAvx2, wordAvx2, digitsAvx2},
+#endif
+};
+
+bool supported(isa which) {
+  switch (which) {
+  case isa::scalar:
+    return true;
+#ifdef TINY_SCAN_X86
+  case isa::sse2:
+    return __builtin_cpu_supports("sse2");
+  case isa::avx2:
+    return __builtin_cpu_supports("avx2");
+#endif
+  default:
+    return false;
+  }
+}
+
+const impl *best() {
+#ifdef TINY_SCAN_X86
+  __builtin_cpu_init();
+#endif
+  const impl *b = impls;
+  for (auto &i : impls) {
+    if (supported(i._isa)) {
+      b = &i;
+    }
+  }
+  return b;
+}
+
+const impl *current = best();
+}
+
+const char *ws(const char *p, const char *end) {
+  return current->_ws(p, end);
+}
+
+const char *word(const char *p, const char *end) {
+  return current->_word(p, end);
+}
+
+const char *digits(const char *p, const char *end) {
+  return current->_digits(p, end);
+}
+
+bool decimal(const char *p, size_t len, int64_t &value) {
+  while (len > 1 && *p == '0') {
+    ++p;
+    --len;
+  }
+  if (len > 19) {
+    return false;
+  }
+
+  uint64_t v = 0;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  for (; len >= 8; p += 8, len -= 8) {
+    v = v * 100000000 + swar8(p);
+  }
+#endif
+  for (; len > 0; ++p, --len) {
+    v = v * 10 + (*p - '0');
+  }
+
+  if (v > uint64_t(INT64_MAX)) {
+    return false;
+  }
+  value = v;
+  return true;
+}
+
+bool select(isa which) {
+  for (auto &i : impls) {
+    if (i._isa == which && supported(which)) {
+      current = &i;
+      return true;
+    }
+  }
+  return false;
+}
+
+isa selected() { return current->_isa; }
+
+const char *name(isa which) {
+  switch (which) {
+  case isa::sse2:
+    return "sse2";
+  case isa::avx2:
+    return "avx2";
+  default:
+    return "scalar";
+  }
+}
+}
+}
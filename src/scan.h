@@ -0,0 +1,34 @@
+//
+//  scan.h
+//  tiny
+//
+//  Created by Иван Дмитриевский on 18/10/26.
+//  Copyright (c) 2026 Ivan Dmitrievsky. All rights reserved.
+//
+
+#ifndef __tiny__scan__
+#define __tiny__scan__
+
+#include <cstddef>
+#include <cstdint>
+
+namespace tiny {
+// Character class runs for the lexer. Each function returns the first byte
+// in [p, end) outside the class. The vector width is picked once at startup
+// from what the CPU supports and can be overridden with select().
+namespace scan {
+enum class isa { scalar, sse2, avx2 };
+
+const char *ws(const char *p, const char *end);
+const char *word(const char *p, const char *end);
+const char *digits(const char *p, const char *end);
+// Value of the decimal digits [p, p + len), false if it exceeds INT64_MAX.
+bool decimal(const char *p, size_t len, int64_t &value);
+
+bool select(isa which);
+isa selected();
+const char *name(isa which);
+}
+}
+
+#endif /* defined(__tiny__scan__) */
@@ -0,0 +1,75 @@
+//
+//  scope.cpp
+//  tiny
+//
+//  Created by Иван Дмитриевский on 18/10/26.
+//  Copyright (c) 2026 Ivan Dmitrievsky. All rights reserved.
+//
+
+#include "scope.h"
+#include "format.h"
+
+#include <cstdlib>
+#include <string>
+#include <unordered_map>
+
+namespace tiny {
+namespace {
+typedef std::unordered_map<std::string, uint32_t> names;
+
+void undeclared(const ast &tree, ast::ref ident) {
+  details pos = tree.where(ident);
+  fmt::printf("Undeclared variable %s at %ld:%ld\n", tree.name(ident),
+              pos._lineNum, pos._linePos);
+  exit(EXIT_FAILURE);
+}
+
+// Gives every ident under r the slot of its name.
+void resolve(const ast &tree, const names &slots, ast::ref r,
+             std::vector<uint32_t> &slot) {
+  for (; r != ast::nil; r = tree[r]._next) {
+    const ast::node &n = tree[r];
+    switch (n._kind) {
+    case ast::kind::ident: {
+      names::const_iterator it = slots.find(tree.name(r));
+      if (it == slots.end()) {
+        undeclared(tree, r);
+      }
+      slot[r] = it->second;
+      break;
+    }
+    case ast::kind::num:
+      break;
+    case ast::kind::ifStmt:
+      resolve(tree, slots, n._c, slot);
+    // fallthrough
+    default:
+      resolve(tree, slots, n._a, slot);
+      resolve(tree, slots, n._b, slot);
+    }
+  }
+}
+}
+
+scope::scope(const ast &tree) : _slot(tree.size(), 0) {
+  ast::ref root = tree.root();
+  if (root == ast::nil) {
+    return;
+  }
+  names slots;
+  for (ast::ref d = tree[root]._a; d != ast::nil; d = tree[d]._next) {
+    ast::ref ident = tree[d]._a;
+    std::string name = tree.name(ident);
+    if (slots.count(name)) {
+      details pos = tree.where(ident);
+      fmt::printf("Variable %s declared again at %ld:%ld\n", name,
+                  pos._lineNum, pos._linePos);
+      exit(EXIT_FAILURE);
+    }
+    _slot[ident] = _init.size();
+    slots.emplace(name, _init.size());
+    _init.push_back(tree[d]._b == ast::nil ? 0 : tree.value(tree[d]._b));
+  }
+  resolve(tree, slots, tree[root]._b, _slot);
+}
+}
@@ -0,0 +1,40 @@
+//
+//  scope.h
+//  tiny
+//
+//  Created by Иван Дмитриевский on 18/10/26.
+//  Copyright (c) 2026 Ivan Dmitrievsky. All rights reserved.
+//
+
+#ifndef __tiny__scope__
+#define __tiny__scope__
+
+#include "ast.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace tiny {
+// Variables of a program resolved to dense slot numbers, in declaration
+// order. Names are compared once, here; whatever runs the program only
+// indexes arrays by slot.
+class scope {
+public:
+  // Reports the first variable that is used undeclared or declared twice
+  // and exits.
+  explicit scope(const ast &tree);
+
+  // Slot of an ident node.
+  uint32_t operator[](ast::ref ident) const { return _slot[ident]; }
+  size_t size() const { return _init.size(); }
+  // Declared values by slot, zero where there is none.
+  const std::vector<int64_t> &init() const { return _init; }
+
+private:
+  // Indexed by node, only meaningful for ident nodes.
+  std::vector<uint32_t> _slot;
+  std::vector<int64_t> _init;
+};
+}
+
+#endif /* defined(__tiny__scope__) */
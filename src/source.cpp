@@ -0,0 +1,108 @@
+//
+//  source.cpp
+//  tiny
+//
+//  Created by Иван Дмитриевский on 18/10/26.
+//  Copyright (c) 2026 Ivan Dmitrievsky. All rights reserved.
+//
+
+#include "format.h"
+#include "source.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace tiny {
+source::source(const std::string &path) {
+  if (!load(path)) {
+    fmt::printf("Cannot open %s\n", path);
+    exit(EXIT_FAILURE);
+  }
+}
+
+source::source(const std::string &path, bool &opened) {
+  opened = load(path);
+}
+
+bool source::load(const std::string &path) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+
+  if (!map(fd)) {
+    read(fd);
+  }
+  close(fd);
+  return true;
+}
+
+source::~source() {
+  if (_mapped) {
+    munmap(const_cast<char *>(_data), _size);
+  }
+}
+
+bool source::map(int fd) {
+  struct stat st;
+  if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0) {
+    return false;
+  }
+
+  void *addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (addr == MAP_FAILED) {
+    return false;
+  }
+  madvise(addr, st.st_size, MADV_SEQUENTIAL);
+
+  _data = static_cast<const char *>(addr);
+  _size = st.st_size;
+  _mapped = true;
+  return true;
+}
+
+void source::read(int fd) {
+  const size_t chunk = 1 << 16;
+  size_t used = 0;
+  for (;;) {
+    _buf.resize(used + chunk);
+    ssize_t n = ::read(fd, _buf.data() + used, chunk);
+    if (n < 0) {
+      fmt::printf("Cannot read input\n");
+      exit(EXIT_FAILURE);
+    }
+    if (n == 0) {
+      break;
+    }
+    used += n;
+  }
+  _buf.resize(used);
+
+  _data = _buf.data();
+  _size = used;
+}
+
+details source::where(size_t off) const {
+  std::call_once(_indexed, [this]() { index(); });
+  size_t line = std::upper_bound(_lines.begin(), _lines.end(), off) -
+                _lines.begin();
+  return {long(line), long(off - _lines[line - 1] + 1)};
+}
+
+void source::index() const {
+  _lines.push_back(0);
+  const char *end = _data + _size;
+  for (const char *p = _data; p != end; ++p) {
+    p = static_cast<const char *>(memchr(p, '\n', end - p));
+    if (!p) {
+      break;
+    }
+    _lines.push_back(p - _data + 1);
+  }
+}
+}
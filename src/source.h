@@ -0,0 +1,57 @@
+//
+//  source.h
+//  tiny
+//
+//  Created by Иван Дмитриевский on 18/10/26.
+//  Copyright (c) 2026 Ivan Dmitrievsky. All rights reserved.
+//
+
+#ifndef __tiny__source__
+#define __tiny__source__
+
+#include "details.h"
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace tiny {
+// Whole program text in one contiguous buffer. Regular files are mapped,
+// anything mmap refuses (pipes, ttys) is read into memory instead.
+class source {
+public:
+  source() = default;
+  explicit source(const std::string &path);
+  // Leaves the source empty and opened false instead of exiting when the
+  // file cannot be opened.
+  source(const std::string &path, bool &opened);
+  // Borrows memory owned by the caller.
+  source(const char *data, size_t size) : _data(data), _size(size) {}
+  ~source();
+
+  source(const source &) = delete;
+  source &operator=(const source &) = delete;
+
+  const char *data() const { return _data; }
+  size_t size() const { return _size; }
+
+  // Line and column of a byte offset. Line starts are only indexed the
+  // first time a position is asked for, normally when reporting an error.
+  details where(size_t off) const;
+
+private:
+  const char *_data = nullptr;
+  size_t _size = 0;
+  bool _mapped = false;
+  std::vector<char> _buf;
+  mutable std::once_flag _indexed;
+  mutable std::vector<size_t> _lines;
+
+  bool load(const std::string &path);
+  bool map(int fd);
+  void read(int fd);
+  void index() const;
+};
+}
+
+#endif /* defined(__tiny__source__) */
@@ -0,0 +1,93 @@
+//
+//  symtab.cpp
+//  tiny
+//
+//  Created by Иван Дмитриевский on 18/10/26.
+//  Copyright (c) 2026 Ivan Dmitrievsky. All rights reserved.
+//
+
+#include "symtab.h"
+
+#include <cstring>
+
+namespace tiny {
+const symtab::id symtab::none;
+
+void symtab::borrow(const char *names, const uint32_t *offs, size_t count,
+                    const id *slots, size_t slotCount) {
+  _names = names;
+  _offs = offs;
+  _count = count;
+  _slots = slots;
+  _slotCount = slotCount;
+}
+
+symtab::id symtab::intern(const std::string &name) {
+  id i = find(name);
+  if (i != none) {
+    return i;
+  }
+
+  if (_ownOffs.empty()) {
+    _ownOffs.push_back(0);
+  }
+  i = _count;
+  _ownNames.insert(_ownNames.end(), name.begin(), name.end());
+  _ownNames.push_back('\0');
+  _ownOffs.push_back(_ownNames.size());
+  ++_count;
+  sync();
+
+  if (2 * _count > _slotCount) {
+    rehash();
+  } else {
+    _ownSlots[slot(name.data(), name.size())] = i;
+  }
+  return i;
+}
+
+symtab::id symtab::find(const char *s, size_t len) const {
+  if (_slotCount == 0) {
+    return none;
+  }
+  return _slots[slot(s, len)];
+}
+
+size_t symtab::hash(const char *s, size_t len) {
+  uint32_t h = 2166136261u;
+  for (size_t i = 0; i < len; ++i) {
+    h = (h ^ static_cast<unsigned char>(s[i])) * 16777619u;
+  }
+  return h;
+}
+
+size_t symtab::slot(const char *s, size_t len) const {
+  size_t mask = _slotCount - 1;
+  size_t i = hash(s, len) & mask;
+  while (_slots[i] != none) {
+    id k = _slots[i];
+    if (_offs[k + 1] - _offs[k] - 1 == len &&
+        memcmp(_names + _offs[k], s, len) == 0) {
+      break;
+    }
+    i = (i + 1) & mask;
+  }
+  return i;
+}
+
+void symtab::rehash() {
+  _ownSlots.assign(_slotCount ? 2 * _slotCount : 16, none);
+  sync();
+  for (size_t i = 0; i < _count; ++i) {
+    const char *n = name(i);
+    _ownSlots[slot(n, strlen(n))] = i;
+  }
+}
+
+void symtab::sync() {
+  _names = _ownNames.data();
+  _offs = _ownOffs.data();
+  _slots = _ownSlots.data();
+  _slotCount = _ownSlots.size();
+}
+}
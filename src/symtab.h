@@ -0,0 +1,69 @@
+//
+//  symtab.h
+//  tiny
+//
+//  Created by Иван Дмитриевский on 18/10/26.
+//  Copyright (c) 2026 Ivan Dmitrievsky. All rights reserved.
+//
+
+#ifndef __tiny__symtab__
+#define __tiny__symtab__
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace tiny {
+// Dense ids for grammar symbols. Names are interned once while the grammar
+// loads, after that lexer and parser only move small integers around.
+//
+// The table is three flat arrays: NUL-terminated names back to back, the
+// offset of every name plus one past the end, and an open-addressed slot
+// array. They are either owned or borrowed from a grammar image.
+class symtab {
+public:
+  typedef uint16_t id;
+  static const id none = 0xffff;
+
+  symtab() = default;
+  symtab(const symtab &) = delete;
+  symtab &operator=(const symtab &) = delete;
+
+  id intern(const std::string &name);
+  id find(const char *s, size_t len) const;
+  id find(const std::string &name) const {
+    return find(name.data(), name.size());
+  }
+
+  const char *name(id i) const { return _names + _offs[i]; }
+  size_t size() const { return _count; }
+
+  // Uses tables laid out by another symtab without copying them.
+  void borrow(const char *names, const uint32_t *offs, size_t count,
+              const id *slots, size_t slotCount);
+
+  const char *names() const { return _names; }
+  size_t namesSize() const { return _count ? _offs[_count] : 0; }
+  const uint32_t *offs() const { return _offs; }
+  const id *slots() const { return _slots; }
+  size_t slotCount() const { return _slotCount; }
+
+private:
+  const char *_names = nullptr;
+  const uint32_t *_offs = nullptr;
+  const id *_slots = nullptr;
+  size_t _count = 0;
+  size_t _slotCount = 0;
+
+  std::vector<char> _ownNames;
+  std::vector<uint32_t> _ownOffs;
+  std::vector<id> _ownSlots;
+
+  static size_t hash(const char *s, size_t len);
+  size_t slot(const char *s, size_t len) const;
+  void rehash();
+  void sync();
+};
+}
+
+#endif /* defined(__tiny__symtab__) */
@@ -0,0 +1,99 @@
+//
+//  tokbuf.cpp
+//  tiny
+//
+//  Created by Иван Дмитриевский on 18/10/26.
+//  Copyright (c) 2026 Ivan Dmitrievsky. All rights reserved.
+//
+
+#include "tokbuf.h"
+
+#include <algorithm>
+
+namespace tiny {
+void tokbuf::clear() {
+  _kinds.clear();
+  _klasses.clear();
+  _offs.clear();
+  _lens.clear();
+  _nums.clear();
+  _numAt.clear();
+}
+
+void tokbuf::reserve(size_t n) {
+  _kinds.reserve(n);
+  _klasses.reserve(n);
+  _offs.reserve(n);
+  _lens.reserve(n);
+}
+
+void tokbuf::push(const token &t) {
+  if (t.isn()) {
+    _numAt.push_back(size());
+    _nums.push_back(t._num);
+  }
+  _kinds.push_back(t._sym == symtab::none ? noSym : t._sym);
+  _klasses.push_back(t._klass);
+  _offs.push_back(t._off);
+  _lens.push_back(t._len);
+}
+
+void tokbuf::append(const tokbuf &other) {
+  uint32_t first = size();
+  for (auto at : other._numAt) {
+    _numAt.push_back(first + at);
+  }
+  _nums.insert(_nums.end(), other._nums.begin(), other._nums.end());
+  _kinds.insert(_kinds.end(), other._kinds.begin(), other._kinds.end());
+  _klasses.insert(_klasses.end(), other._klasses.begin(),
+                  other._klasses.end());
+  _offs.insert(_offs.end(), other._offs.begin(), other._offs.end());
+  _lens.insert(_lens.end(), other._lens.begin(), other._lens.end());
+}
+
+symtab::id tokbuf::sym(size_t i) const {
+  return _kinds[i] == noSym ? symtab::none : _kinds[i];
+}
+
+int64_t tokbuf::num(size_t i) const {
+  auto at = std::lower_bound(_numAt.begin(), _numAt.end(), i);
+  return at != _numAt.end() && *at == i ? _nums[at - _numAt.begin()] : 0;
+}
+
+token tokbuf::operator[](size_t i) const { return at(i, num(i)); }
+
+token tokbuf::at(size_t i, int64_t num) const {
+  token t;
+  t._off = _offs[i];
+  t._len = _lens[i];
+  t._sym = sym(i);
+  t._klass = _klasses[i];
+  t._num = num;
+  return t;
+}
+
+size_t tokbuf::bytes() const {
+  return _kinds.size() * sizeof(uint8_t) +
+         _klasses.size() * sizeof(token::klass) +
+         _offs.size() * sizeof(uint32_t) + _lens.size() * sizeof(uint32_t) +
+         _nums.size() * sizeof(int64_t) + _numAt.size() * sizeof(uint32_t);
+}
+
+tokbuf::cursor::cursor(const tokbuf &buf, const source &src)
+    : _buf(buf), _src(src) {
+  load();
+}
+
+void tokbuf::cursor::advance() {
+  ++_i;
+  load();
+}
+
+void tokbuf::cursor::load() {
+  if (done()) {
+    return;
+  }
+  bool isNum = _n < _buf._numAt.size() && _buf._numAt[_n] == _i;
+  _tok = _buf.at(_i, isNum ? _buf._nums[_n++] : 0);
+}
+}
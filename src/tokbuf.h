@@ -0,0 +1,69 @@
+//
+//  tokbuf.h
+//  tiny
+//
+//  Created by Иван Дмитриевский on 18/10/26.
+//  Copyright (c) 2026 Ivan Dmitrievsky. All rights reserved.
+//
+
+#ifndef __tiny__tokbuf__
+#define __tiny__tokbuf__
+
+#include "source.h"
+#include "token.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace tiny {
+// Tokens of a whole source as parallel arrays: one byte of terminal id and
+// one of class, 32-bit offset and length. Lines and columns are recovered
+// from the offset by the source when needed. Values of number literals are
+// stored apart, together with the index of the token they belong to.
+class tokbuf {
+public:
+  void clear();
+  void reserve(size_t n);
+  void push(const token &t);
+  void append(const tokbuf &other);
+
+  size_t size() const { return _kinds.size(); }
+  bool empty() const { return _kinds.empty(); }
+  symtab::id sym(size_t i) const;
+  int64_t num(size_t i) const;
+  token operator[](size_t i) const;
+  size_t bytes() const;
+
+  class cursor {
+  public:
+    cursor(const tokbuf &buf, const source &src);
+
+    bool done() const { return _i == _buf.size(); }
+    const token &peek() const { return _tok; }
+    void advance();
+    const source &src() const { return _src; }
+
+  private:
+    const tokbuf &_buf;
+    const source &_src;
+    size_t _i = 0;
+    size_t _n = 0;
+    token _tok;
+
+    void load();
+  };
+
+private:
+  static const uint8_t noSym = 0xff;
+  std::vector<uint8_t> _kinds;
+  std::vector<token::klass> _klasses;
+  std::vector<uint32_t> _offs;
+  std::vector<uint32_t> _lens;
+  std::vector<int64_t> _nums;
+  std::vector<uint32_t> _numAt;
+
+  token at(size_t i, int64_t num) const;
+};
+}
+
+#endif /* defined(__tiny__tokbuf__) */
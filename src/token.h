@@ -9,20 +9,32 @@
 #ifndef __tiny__token__
 #define __tiny__token__
 
-#include "details.h"
+#include "source.h"
+#include "symtab.h"
 
+#include <cstdint>
 #include <string>
 
 namespace tiny {
+// The lexer settles the terminal: _sym is the keyword or operator itself,
+// or the grammar's ident or num. The spelling stays in the source at _off,
+// the value of a number in _num.
 struct token {
-  enum class klass { word, num, op };
-  std::string _val;
+  enum class klass : uint8_t { keyWord, ident, num, op };
+  uint32_t _off;
+  uint32_t _len;
+  symtab::id _sym;
   klass _klass;
-  details _info;
+  int64_t _num;
 
-  bool isw() { return _klass == klass::word; }
-  bool isn() { return _klass == klass::num; }
-  bool iso() { return _klass == klass::op; }
+  std::string val(const source &src) const {
+    return std::string(src.data() + _off, _len);
+  }
+
+  bool isk() const { return _klass == klass::keyWord; }
+  bool isi() const { return _klass == klass::ident; }
+  bool isn() const { return _klass == klass::num; }
+  bool iso() const { return _klass == klass::op; }
 };
 }
 
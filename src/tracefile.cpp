@@ -0,0 +1,223 @@
+//
+//  tracefile.cpp
+//  tiny
+//
+//  Created by Иван Дмитриевский on 18/10/26.
+//  Copyright (c) 2026 Ivan Dmitrievsky. All rights reserved.
+//
+
+#include "fdwriter.h"
+#include "format.h"
+#include "tracefile.h"
+
+#include <cstring>
+
+namespace tiny {
+namespace {
+const char magic[7] = {'t', 'i', 'n', 'y', 't', 'r', 'c'};
+const size_t headerSize = sizeof(magic) + 2;
+const size_t bufSize = 1 << 16;
+
+// The rule of every nonterminal that has exactly one, -1 for the others.
+std::vector<int16_t> onlyRules(const grammar &gramm) {
+  std::vector<int16_t> only(gramm.nonterms().size(), -1);
+  std::vector<size_t> count(only.size(), 0);
+  for (size_t r = 0; r < gramm.rules(); ++r) {
+    symtab::id nt = gramm.lhs(r)._id;
+    only[nt] = ++count[nt] == 1 ? r : -1;
+  }
+  return only;
+}
+
+void putVarint(std::string &out, size_t v) {
+  for (; v >= 0x80; v >>= 7) {
+    out += char(v | 0x80);
+  }
+  out += char(v);
+}
+
+void putRun(std::string &out, uint8_t rule, size_t n) {
+  if (n > tracefile::minRun) {
+    out += char(rule);
+    out += char(tracefile::run);
+    putVarint(out, n - 1);
+  } else {
+    out.append(n, char(rule));
+  }
+}
+}
+
+tracewriter::tracewriter(int fd, const grammar &gramm)
+    : _gramm(gramm), _only(onlyRules(gramm)), _fd(fd) {
+  if (gramm.rules() >= tracefile::run) {
+    fmt::printf("Traces hold rule numbers below %d, the grammar has %d "
+                "rules\n",
+                tracefile::run, gramm.rules());
+    exit(EXIT_FAILURE);
+  }
+  _buf.reserve(bufSize + bufSize / 4);
+  _buf.append(magic, sizeof(magic));
+  _buf += char(tracefile::version);
+  _buf += char(gramm.rules());
+}
+
+tracewriter::~tracewriter() { flush(); }
+
+void tracewriter::put(const parser::trace &rules, bool parsed) {
+  encode(rules, parsed, _buf);
+  spill();
+}
+
+void tracewriter::put(const std::string &record) {
+  _buf += record;
+  spill();
+}
+
+void tracewriter::spill() {
+  if (_buf.size() >= bufSize) {
+    flush();
+  }
+}
+
+void tracewriter::flush() {
+  fdwriter::write(_fd, _buf.data(), _buf.size());
+  _buf.clear();
+}
+
+void tracewriter::encode(const parser::trace &rules, bool parsed,
+                         std::string &out) const {
+  putVarint(out, rules.size() << 1 | (parsed ? 0 : 1));
+  uint8_t last = tracefile::run;
+  size_t n = 0;
+  for (size_t i = 0; i < rules.size(); ++i) {
+    uint8_t rule = rules[i];
+    if (parsed && i > 0 && _only[_gramm.lhs(rule)._id] == rule) {
+      continue;
+    }
+    if (rule == last) {
+      ++n;
+      continue;
+    }
+    putRun(out, last, n);
+    last = rule;
+    n = 1;
+  }
+  putRun(out, last, n);
+}
+
+tracereader::tracereader(const source &src, const grammar &gramm)
+    : _gramm(gramm), _only(onlyRules(gramm)),
+      _cur(reinterpret_cast<const uint8_t *>(src.data())),
+      _end(_cur + src.size()) {
+  if (src.size() < headerSize || memcmp(_cur, magic, sizeof(magic)) != 0) {
+    fmt::printf("Input is not a rule trace\n");
+    exit(EXIT_FAILURE);
+  }
+  if (_cur[sizeof(magic)] != tracefile::version) {
+    fmt::printf("Trace has version %d, expected %d\n", _cur[sizeof(magic)],
+                tracefile::version);
+    exit(EXIT_FAILURE);
+  }
+  if (_cur[sizeof(magic) + 1] != gramm.rules()) {
+    fmt::printf("Trace was written for a grammar with %d rules, this one "
+                "has %d\n",
+                _cur[sizeof(magic) + 1], gramm.rules());
+    exit(EXIT_FAILURE);
+  }
+  _cur += headerSize;
+}
+
+bool tracereader::next(parser::trace &rules, bool &parsed) {
+  rules.clear();
+  if (done()) {
+    return false;
+  }
+  size_t head = varint();
+  size_t count = head >> 1;
+  parsed = (head & 1) == 0;
+  rules.reserve(count);
+  _last = tracefile::run;
+  _repeat = 0;
+  _stack.clear();
+
+  if (!parsed) {
+    while (rules.size() < count) {
+      rules.push_back(take());
+    }
+  } else if (count > 0) {
+    apply(rules, take());
+    while (rules.size() < count) {
+      if (_stack.empty()) {
+        corrupt();
+      }
+      symtab::id nt = _stack.back();
+      _stack.pop_back();
+      uint8_t rule = _only[nt] >= 0 ? _only[nt] : take();
+      if (_gramm.lhs(rule)._id != nt) {
+        corrupt();
+      }
+      apply(rules, rule);
+    }
+  }
+  if (_repeat > 0) {
+    corrupt();
+  }
+  return true;
+}
+
+uint8_t tracereader::take() {
+  if (_repeat > 0) {
+    --_repeat;
+    return _last;
+  }
+  if (_cur == _end) {
+    corrupt();
+  }
+  uint8_t b = *_cur++;
+  if (b == tracefile::run) {
+    _repeat = varint();
+    if (_last == tracefile::run || _repeat == 0) {
+      corrupt();
+    }
+    --_repeat;
+  } else if (b < _gramm.rules()) {
+    _last = b;
+  } else {
+    corrupt();
+  }
+  return _last;
+}
+
+// Expands rule in the derivation: its nonterminals, leftmost on top.
+void tracereader::apply(parser::trace &rules, uint8_t rule) {
+  rules.push_back(rule);
+  grammar::span body = _gramm.rhs(rule);
+  for (const uint16_t *it = body.end(); it != body.begin();) {
+    grammar::lexem l = grammar::decode(*--it);
+    if (!l._term) {
+      _stack.push_back(l._id);
+    }
+  }
+}
+
+size_t tracereader::varint() {
+  size_t v = 0;
+  for (unsigned shift = 0; shift < 64; shift += 7) {
+    if (_cur == _end) {
+      corrupt();
+    }
+    uint8_t b = *_cur++;
+    v |= size_t(b & 0x7f) << shift;
+    if (b < 0x80) {
+      return v;
+    }
+  }
+  corrupt();
+  return 0;
+}
+
+void tracereader::corrupt() const {
+  fmt::printf("Rule trace is corrupt\n");
+  exit(EXIT_FAILURE);
+}
+}
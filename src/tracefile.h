@@ -0,0 +1,88 @@
+//
+//  tracefile.h
+//  tiny
+//
+//  Created by Иван Дмитриевский on 18/10/26.
+//  Copyright (c) 2026 Ivan Dmitrievsky. All rights reserved.
+//
+
+#ifndef __tiny__tracefile__
+#define __tiny__tracefile__
+
+#include "grammar.h"
+#include "parser.h"
+#include "source.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace tiny {
+// Rule traces of any number of programs in one binary stream. The header
+// is "tinytrc", a version byte and the rule count of the grammar. Every
+// program is then a record: a varint of (rules << 1 | failed) and rule
+// bytes. A record of a parsed program leaves out every rule but the first
+// whose nonterminal has no other rule; the reader puts them back by
+// replaying the leftmost derivation. Failed parses are kept whole. A rule
+// byte repeated more than minRun times in a row is written once, followed
+// by the run byte and a varint of how many more times it repeats.
+namespace tracefile {
+const uint8_t version = 1;
+const uint8_t run = 0xff;
+const size_t minRun = 3;
+}
+
+// Encodes traces into a buffer and writes it to a file descriptor whenever
+// it fills up, so any number of programs stream through a fixed amount of
+// memory.
+class tracewriter {
+public:
+  tracewriter(int fd, const grammar &gramm);
+  ~tracewriter();
+
+  tracewriter(const tracewriter &) = delete;
+  tracewriter &operator=(const tracewriter &) = delete;
+
+  void put(const parser::trace &rules, bool parsed);
+  // A record made by encode(), for callers that encode on other threads.
+  void put(const std::string &record);
+  void flush();
+
+  void encode(const parser::trace &rules, bool parsed,
+              std::string &out) const;
+
+private:
+  const grammar &_gramm;
+  std::vector<int16_t> _only;
+  int _fd;
+  std::string _buf;
+
+  void spill();
+};
+
+// Replays the records of a trace written for the same grammar.
+class tracereader {
+public:
+  tracereader(const source &src, const grammar &gramm);
+
+  bool done() const { return _cur == _end; }
+  // Next record into rules; false once the stream is exhausted.
+  bool next(parser::trace &rules, bool &parsed);
+
+private:
+  const grammar &_gramm;
+  std::vector<int16_t> _only;
+  std::vector<symtab::id> _stack;
+  const uint8_t *_cur;
+  const uint8_t *_end;
+  uint8_t _last = tracefile::run;
+  size_t _repeat = 0;
+
+  uint8_t take();
+  void apply(parser::trace &rules, uint8_t rule);
+  size_t varint();
+  void corrupt() const;
+};
+}
+
+#endif /* defined(__tiny__tracefile__) */
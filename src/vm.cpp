@@ -0,0 +1,193 @@
+//
+//  vm.cpp
+//  tiny
+//
+//  Created by Иван Дмитриевский on 18/10/26.
+//  Copyright (c) 2026 Ivan Dmitrievsky. All rights reserved.
+//
+
+#include "vm.h"
+#include "format.h"
+
+#include <cstdlib>
+
+#if defined(__GNUC__)
+#define TINY_THREADED 1
+#endif
+
+#ifdef TINY_THREADED
+// Labels as values are an extension -pedantic rejects.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+#define TINY_OP(o) o
+#define TINY_DISPATCH()                                                        \
+  do {                                                                         \
+    ins = *pc++;                                                               \
+    if (Counting) {                                                            \
+      ++executed;                                                              \
+    }                                                                          \
+    goto *labels[ins & 0xff];                                                  \
+  } while (0)
+#else
+#define TINY_OP(o) case bytecode::op::o
+#define TINY_DISPATCH() continue
+#endif
+
+namespace tiny {
+vm::vm(const bytecode &code) : _code(code), _stack(code.depth()) {}
+
+void vm::run(fdwriter &out) { exec<false>(out); }
+
+uint64_t vm::count(fdwriter &out) { return exec<true>(out); }
+
+template <bool Counting> uint64_t vm::exec(fdwriter &out) {
+  _vars = _code.init();
+  const uint32_t *code = _code.code().data();
+  const uint32_t *pc = code;
+  const int64_t *consts = _code.consts().data();
+  int64_t *vars = _vars.data();
+  // One past the top value.
+  int64_t *sp = _stack.data();
+  uint64_t executed = 0;
+  uint32_t ins;
+
+#ifdef TINY_THREADED
+  // In the order of bytecode::op.
+  static const void *const labels[] = {
+      &&push,       &&load,       &&store,      &&add,        &&sub,
+      &&mul,        &&div,        &&lt,         &&le,         &&gt,
+      &&ge,         &&eq,         &&ne,         &&lnot,       &&truth,
+      &&andJump,    &&orJump,     &&jump,       &&jumpIf,     &&jumpUnless,
+      &&print,      &&halt};
+  static_assert(sizeof(labels) / sizeof(*labels) == bytecode::ops,
+                "every opcode needs a label");
+  TINY_DISPATCH();
+#else
+  for (;;) {
+    ins = *pc++;
+    if (Counting) {
+      ++executed;
+    }
+    switch (bytecode::code(ins)) {
+#endif
+
+  TINY_OP(push):
+    *sp++ = consts[bytecode::arg(ins)];
+    TINY_DISPATCH();
+  TINY_OP(load):
+    *sp++ = vars[bytecode::arg(ins)];
+    TINY_DISPATCH();
+  TINY_OP(store):
+    vars[bytecode::arg(ins)] = *--sp;
+    TINY_DISPATCH();
+  TINY_OP(add):
+    --sp;
+    sp[-1] = int64_t(uint64_t(sp[-1]) + uint64_t(sp[0]));
+    TINY_DISPATCH();
+  TINY_OP(sub):
+    --sp;
+    sp[-1] = int64_t(uint64_t(sp[-1]) - uint64_t(sp[0]));
+    TINY_DISPATCH();
+  TINY_OP(mul):
+    --sp;
+    sp[-1] = int64_t(uint64_t(sp[-1]) * uint64_t(sp[0]));
+    TINY_DISPATCH();
+  TINY_OP(div):
+    --sp;
+    if (sp[0] == 0) {
+      fail(out, "Division by zero");
+    }
+    // The one quotient that overflows wraps like the other operators.
+    sp[-1] = sp[0] == -1 ? int64_t(0 - uint64_t(sp[-1])) : sp[-1] / sp[0];
+    TINY_DISPATCH();
+  TINY_OP(lt):
+    --sp;
+    sp[-1] = sp[-1] < sp[0];
+    TINY_DISPATCH();
+  TINY_OP(le):
+    --sp;
+    sp[-1] = sp[-1] <= sp[0];
+    TINY_DISPATCH();
+  TINY_OP(gt):
+    --sp;
+    sp[-1] = sp[-1] > sp[0];
+    TINY_DISPATCH();
+  TINY_OP(ge):
+    --sp;
+    sp[-1] = sp[-1] >= sp[0];
+    TINY_DISPATCH();
+  TINY_OP(eq):
+    --sp;
+    sp[-1] = sp[-1] == sp[0];
+    TINY_DISPATCH();
+  TINY_OP(ne):
+    --sp;
+    sp[-1] = sp[-1] != sp[0];
+    TINY_DISPATCH();
+  TINY_OP(lnot):
+    sp[-1] = !sp[-1];
+    TINY_DISPATCH();
+  TINY_OP(truth):
+    sp[-1] = sp[-1] != 0;
+    TINY_DISPATCH();
+  TINY_OP(andJump):
+    if (sp[-1] == 0) {
+      pc = code + bytecode::arg(ins);
+    } else {
+      --sp;
+    }
+    TINY_DISPATCH();
+  TINY_OP(orJump):
+    if (sp[-1] != 0) {
+      sp[-1] = 1;
+      pc = code + bytecode::arg(ins);
+    } else {
+      --sp;
+    }
+    TINY_DISPATCH();
+  TINY_OP(jump):
+    pc = code + bytecode::arg(ins);
+    TINY_DISPATCH();
+  TINY_OP(jumpIf):
+    if (*--sp != 0) {
+      pc = code + bytecode::arg(ins);
+    }
+    TINY_DISPATCH();
+  TINY_OP(jumpUnless):
+    if (*--sp == 0) {
+      pc = code + bytecode::arg(ins);
+    }
+    TINY_DISPATCH();
+  TINY_OP(print): {
+    fmt::Writer &w = out.out();
+    uint32_t n = bytecode::arg(ins);
+    sp -= n;
+    for (uint32_t i = 0; i < n; ++i) {
+      if (i > 0) {
+        w << ' ';
+      }
+      w << sp[i];
+    }
+    w << '\n';
+    out.spill();
+    TINY_DISPATCH();
+  }
+  TINY_OP(halt):
+    return executed;
+
+#ifndef TINY_THREADED
+    }
+  }
+#endif
+}
+
+#ifdef TINY_THREADED
+#pragma GCC diagnostic pop
+#endif
+
+void vm::fail(fdwriter &out, const char *what) {
+  out.flush();
+  fmt::printf("%s\n", what);
+  exit(EXIT_FAILURE);
+}
+}
@@ -0,0 +1,46 @@
+//
+//  vm.h
+//  tiny
+//
+//  Created by Иван Дмитриевский on 18/10/26.
+//  Copyright (c) 2026 Ivan Dmitrievsky. All rights reserved.
+//
+
+#ifndef __tiny__vm__
+#define __tiny__vm__
+
+#include "bytecode.h"
+#include "fdwriter.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace tiny {
+// Stack machine for bytecode, with the semantics of interp. Where the
+// compiler has labels as values (GCC, Clang) every instruction jumps
+// straight to the next one's handler through a table; elsewhere it runs
+// a switch in a loop.
+class vm {
+public:
+  explicit vm(const bytecode &code);
+
+  vm(const vm &) = delete;
+  vm &operator=(const vm &) = delete;
+
+  // Runs the program from its initial values. Division by zero is
+  // reported and exits.
+  void run(fdwriter &out);
+  // Same, and returns how many instructions were executed.
+  uint64_t count(fdwriter &out);
+
+private:
+  const bytecode &_code;
+  std::vector<int64_t> _vars;
+  std::vector<int64_t> _stack;
+
+  template <bool Counting> uint64_t exec(fdwriter &out);
+  void fail(fdwriter &out, const char *what);
+};
+}
+
+#endif /* defined(__tiny__vm__) */
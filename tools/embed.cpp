@@ -0,0 +1,25 @@
+//
+//  embed.cpp
+//  tiny
+//
+//  Created by Иван Дмитриевский on 18/10/26.
+//  Copyright (c) 2026 Ivan Dmitrievsky. All rights reserved.
+//
+//  Build step: turns grammar.json into the header of constexpr tables that
+//  the default grammar is compiled from. The predict table is derived and
+//  checked for LL(1) conflicts on the way.
+//
+
+#include "format.h"
+#include "grammar.h"
+
+#include <cstdlib>
+
+int main(int argc, const char *argv[]) {
+  if (argc != 3) {
+    fmt::printf("Usage: %s grammar.json out.h\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+  tiny::grammar(argv[1]).emit(argv[2]);
+  return 0;
+}
@@ -0,0 +1,123 @@
+//
+//  rdgen.cpp
+//  tiny
+//
+//  Created by Иван Дмитриевский on 18/10/26.
+//  Copyright (c) 2026 Ivan Dmitrievsky. All rights reserved.
+//
+//  Build step: writes a recursive-descent parser for grammar.json, one
+//  function per nonterminal switching on terminal ids from the predict
+//  table. The driver it runs against lives in src/descent.cpp.
+//
+
+#include "format.h"
+#include "grammar.h"
+
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace {
+std::string fn(const char *nonterm) {
+  std::string s = "nt_";
+  for (const char *c = nonterm; *c; ++c) {
+    s += isalnum(static_cast<unsigned char>(*c)) ? *c : '_';
+  }
+  return s;
+}
+
+// A function name per nonterminal. Names that only differ in characters
+// fn() replaces, like a-b and a_b, get a numbered suffix after the first.
+std::vector<std::string> fns(const tiny::symtab &nonterms) {
+  std::vector<std::string> names;
+  std::set<std::string> taken;
+  for (size_t nt = 0; nt < nonterms.size(); ++nt) {
+    std::string base = fn(nonterms.name(nt));
+    std::string name = base;
+    for (int n = 2; !taken.insert(name).second; ++n) {
+      name = base + "_" + std::to_string(n);
+    }
+    names.push_back(name);
+  }
+  return names;
+}
+}
+
+int main(int argc, const char *argv[]) {
+  if (argc != 3) {
+    fmt::printf("Usage: %s grammar.json out.h\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+  tiny::grammar g(argv[1]);
+  const tiny::symtab &terms = g.terms();
+  const tiny::symtab &nonterms = g.nonterms();
+  std::vector<std::string> names = fns(nonterms);
+
+  fmt::MemoryWriter out;
+  out << "// Generated by tools/rdgen from grammar.json.\n"
+      << "// Do not edit.\n\n"
+      << "#include <cstdint>\n\n"
+      << "namespace tiny {\nnamespace generated {\n"
+      << "// grammar::fingerprint() of the grammar the code was made for.\n"
+      << "constexpr uint64_t fingerprint = " << g.fingerprint() << "u;\n\n"
+      << "template <class P> struct descent {\n";
+
+  for (size_t nt = 0; nt < nonterms.size(); ++nt) {
+    std::map<size_t, std::vector<size_t>> cases;
+    for (size_t t = 0; t < terms.size(); ++t) {
+      bool found = false;
+      size_t r = g.predict(nt, t, found);
+      if (found) {
+        cases[r].push_back(t);
+      }
+    }
+
+    out << "  // <" << nonterms.name(nt) << ">\n"
+        << "  static bool " << names[nt] << "(P &p) {\n"
+        << "    if (!p.more()) {\n"
+        << "      return p.eof(" << nt << ");\n"
+        << "    }\n"
+        << "    switch (p.sym()) {\n";
+    for (auto &c : cases) {
+      for (auto t : c.second) {
+        out << "    case " << t << ": // " << terms.name(t) << "\n";
+      }
+      out << "      p.rule(" << c.first << ");\n";
+      tiny::grammar::span body = g.rhs(c.first);
+      if (body.empty()) {
+        out << "      return true;\n";
+        continue;
+      }
+      out << "      return ";
+      for (size_t i = 0; i < body.size(); ++i) {
+        out << (i ? " &&\n             " : "");
+        if (body[i]._term) {
+          out << "p.term(" << body[i]._id << ")";
+        } else {
+          out << names[body[i]._id] << "(p)";
+        }
+      }
+      out << ";\n";
+    }
+    out << "    default:\n"
+        << "      return p.fail(" << nt << ");\n"
+        << "    }\n"
+        << "  }\n\n";
+  }
+
+  out << "  static bool start(P &p) { return "
+      << names[g.lhs(0)._id] << "(p); }\n"
+      << "};\n}\n}\n";
+
+  std::ofstream file(argv[2], std::ios::trunc);
+  file.write(out.data(), out.size());
+  if (!file) {
+    fmt::printf("Cannot write %s\n", argv[2]);
+    return EXIT_FAILURE;
+  }
+  return 0;
+}